@@ -0,0 +1,670 @@
+// Benchmarks of the ECS storage, built with -DECS_BENCHMARKS=ON
+// The single container operations are timed on the original hash map and the paged sparse set. The backends
+// are then compared on a synthetic level with 50k zombies, 20k platforms and 5k falling items, created
+// interleaved like a level load does. Every backend runs the same steps on it: the zombie query of the
+// physics step, toggling Gravity on some zombies, killing some zombies and destroying the level scope.
+// The gravity and integration loops of the physics step are timed as views and as the has() probes they
+// replaced. The sweep and prune broadphase is compared against the loop over all pairs it replaced.
+// The checksums and pairs of every case have to agree.
+
+// stlib
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+// internal
+#include "tiny_ecs.hpp"
+#include "tiny_ecs_archetype.hpp"
+#include "sweep_and_prune.hpp"
+
+// Stand-ins for the game components, with their sizes but without the rendering dependencies
+struct Motion
+{
+	float position[2] = { 0, 0 };
+	float angle = 0;
+	float velocity[2] = { 0, 0 };
+	float scale[2] = { 10, 10 };
+	bool moving = false;
+};
+struct Gravity {};
+struct NormalZombie
+{
+	bool is_alerted = false;
+	bool facing_right = true;
+	float alerted_speed = 100;
+};
+struct RenderRequest
+{
+	int used_texture = 0;
+	int used_effect = 0;
+	int used_geometry = 0;
+};
+struct Platform
+{
+	float position[2] = { 0, 0 };
+	float scale[2] = { 10, 10 };
+};
+struct Spikeball {};
+struct Bullet {};
+struct Eatable {};
+
+// The storage the game started with, a hash map from entity to the position in the arrays
+template <typename Component>
+class HashContainer
+{
+	std::unordered_map<unsigned int, unsigned int> map_entity_componentID;
+public:
+	std::vector<Component> components;
+	std::vector<Entity> entities;
+
+	Component& insert(Entity e, Component c)
+	{
+		map_entity_componentID[e] = (unsigned int)components.size();
+		components.push_back(std::move(c));
+		entities.push_back(e);
+		return components.back();
+	}
+	Component& get(Entity e)
+	{
+		return components[map_entity_componentID[e]];
+	}
+	bool has(Entity e)
+	{
+		return map_entity_componentID.count(e) > 0;
+	}
+	void remove(Entity e)
+	{
+		auto it = map_entity_componentID.find(e);
+		if (it == map_entity_componentID.end())
+			return;
+		unsigned int i = it->second;
+		components[i] = std::move(components.back());
+		entities[i] = entities.back();
+		map_entity_componentID[entities.back()] = i;
+		map_entity_componentID.erase(e);
+		components.pop_back();
+		entities.pop_back();
+	}
+};
+
+struct HashRegistry
+{
+	HashContainer<Motion> motions;
+	HashContainer<Gravity> gravities;
+	HashContainer<NormalZombie> zombies;
+	HashContainer<RenderRequest> renderRequests;
+	HashContainer<Platform> platforms;
+	HashContainer<Spikeball> spikeballs;
+	HashContainer<Bullet> bullets;
+	HashContainer<Eatable> eatables;
+
+	void remove_all_components_of(Entity e)
+	{
+		motions.remove(e);
+		gravities.remove(e);
+		zombies.remove(e);
+		renderRequests.remove(e);
+		platforms.remove(e);
+		spikeballs.remove(e);
+		bullets.remove(e);
+		eatables.remove(e);
+	}
+};
+
+using SparseRegistry = ComponentRegistry<Motion, Gravity, NormalZombie, RenderRequest, Platform, Spikeball, Bullet, Eatable>;
+using ChunkRegistry = ArchetypeRegistry<Motion, Gravity, NormalZombie, RenderRequest, Platform, Spikeball, Bullet, Eatable>;
+
+// A program has a single registry, see ComponentRegistry::commands, the cases that need one share it
+static SparseRegistry sparse_registry;
+
+static constexpr unsigned char level_scope = 1;
+static constexpr int zombie_count = 50000;
+static constexpr int platform_count = 20000;
+static constexpr int falling_count = 5000;
+static constexpr int changed_count = 1000; // the zombies whose Gravity is toggled and that are killed
+static constexpr int runs = 5;
+
+static double now_us()
+{
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// The zombie part of the physics step
+static void move_zombie(Motion& motion, const NormalZombie& zombie)
+{
+	motion.velocity[1] += 30.f;
+	if (zombie.is_alerted)
+		motion.velocity[0] = zombie.facing_right ? zombie.alerted_speed : -zombie.alerted_speed;
+	motion.position[0] += motion.velocity[0] * 0.016f;
+	motion.position[1] += motion.velocity[1] * 0.016f;
+}
+
+struct Timings
+{
+	double create = 1e18, query = 1e18, toggle = 1e18, kill = 1e18, destroy = 1e18;
+	double checksum = 0;
+};
+
+static void keep_best(double& best, double start)
+{
+	best = std::min(best, now_us() - start);
+}
+
+// The results of the container operations, see run_container_ops
+struct OpTimings
+{
+	double insert = 1e18, has = 1e18, get = 1e18, remove = 1e18;
+	double checksum = 0;
+};
+
+static constexpr int op_count = 100000;
+
+// Insert every other entity, probe all of them with has(), read the inserted ones with get() and remove them
+// in a shuffled order, the way entities die during a level
+template <typename Container>
+static OpTimings run_container_ops(const std::vector<Entity>& entities, const std::vector<Entity>& shuffled)
+{
+	OpTimings timings;
+	for (int run = 0; run < runs; run++)
+	{
+		Container container;
+		double start = now_us();
+		for (int i = 0; i < op_count; i += 2)
+		{
+			Motion motion;
+			motion.position[1] = float(i);
+			container.insert(entities[i], motion);
+		}
+		keep_best(timings.insert, start);
+
+		unsigned int found = 0;
+		start = now_us();
+		for (Entity e : entities)
+			found += container.has(e);
+		keep_best(timings.has, start);
+
+		double sum = 0;
+		start = now_us();
+		for (int i = 0; i < op_count; i += 2)
+			sum += container.get(entities[i]).position[1];
+		keep_best(timings.get, start);
+
+		start = now_us();
+		for (Entity e : shuffled)
+			container.remove(e);
+		keep_best(timings.remove, start);
+		timings.checksum = sum + found;
+	}
+	return timings;
+}
+
+static void print_ops(const char* name, const OpTimings& timings)
+{
+	printf("%-12s %10.1f %10.1f %10.1f %10.1f %14.1f\n", name, timings.insert, timings.has, timings.get, timings.remove,
+		timings.checksum);
+}
+
+// The gravity and integration loops of the physics step, each as the original loop that probes the containers
+// with has() on both storages, and as a view
+struct LoopTimings
+{
+	double hash = 1e18, sparse = 1e18, view = 1e18;
+	double hash_checksum = 0, sparse_checksum = 0, view_checksum = 0;
+};
+
+static unsigned int probed_bullets = 0; // keeps the dead probe of the old integration loop from being optimized out
+
+static void reset_motions(const std::vector<Motion*>& motions)
+{
+	for (size_t i = 0; i < motions.size(); i++)
+	{
+		motions[i]->position[0] = motions[i]->position[1] = 0;
+		motions[i]->velocity[0] = float(i % 7);
+		motions[i]->velocity[1] = float(i % 5);
+	}
+}
+
+// Time a loop on freshly reset motions and sum up one coordinate of them afterwards
+template <typename Loop>
+static void time_loop(const std::vector<Motion*>& motions, int coordinate, double& best, double& checksum, Loop loop)
+{
+	for (int run = 0; run < runs * 20; run++)
+	{
+		reset_motions(motions);
+		double start = now_us();
+		loop();
+		keep_best(best, start);
+	}
+	checksum = 0;
+	for (Motion* motion : motions)
+		checksum += coordinate == 0 ? motion->position[0] + motion->position[1] : motion->velocity[1];
+}
+
+// Platforms only have a Motion, falling items also have Gravity, a few of them are spikeballs that don't fall
+// and some are bullets, for the probe of the old integration loop
+static void run_view_loops(int platforms, int falling, LoopTimings& gravity, LoopTimings& integrate)
+{
+	HashRegistry hash;
+	SparseRegistry& registry = sparse_registry;
+	Entity::enter_scope(level_scope);
+	for (int i = 0; i < platforms + falling; i++)
+	{
+		Entity e;
+		hash.motions.insert(e, {});
+		registry.get<Motion>().insert(e, {});
+		if (i < platforms)
+			continue;
+		hash.gravities.insert(e, {});
+		registry.get<Gravity>().emplace(e);
+		if (i % 10 == 0)
+		{
+			hash.spikeballs.insert(e, {});
+			registry.get<Spikeball>().emplace(e);
+		}
+		if (i % 7 == 0)
+		{
+			hash.bullets.insert(e, {});
+			registry.get<Bullet>().emplace(e);
+		}
+		if (i % 21 == 0)
+		{
+			hash.eatables.insert(e, {});
+			registry.get<Eatable>().emplace(e);
+		}
+	}
+	Entity::enter_scope(Entity::global_scope);
+
+	// Both storages keep the motions in creation order, so the checksums sum up the same values
+	std::vector<Motion*> hash_motions, sparse_motions;
+	for (Motion& motion : hash.motions.components)
+		hash_motions.push_back(&motion);
+	for (unsigned int i = 0; i < registry.get<Motion>().size(); i++)
+		sparse_motions.push_back(&registry.get<Motion>().components[i]);
+
+	time_loop(hash_motions, 1, gravity.hash, gravity.hash_checksum, [&]() {
+		for (unsigned int i = 0; i < hash.gravities.entities.size(); i++)
+		{
+			Entity e = hash.gravities.entities[i];
+			if (!hash.spikeballs.has(e) && hash.motions.has(e))
+				hash.motions.get(e).velocity[1] += 30.f;
+		}
+	});
+	time_loop(sparse_motions, 1, gravity.sparse, gravity.sparse_checksum, [&]() {
+		for (Entity e : registry.get<Gravity>().entities)
+			if (!registry.get<Spikeball>().has(e) && registry.get<Motion>().has(e))
+				registry.get<Motion>().get(e).velocity[1] += 30.f;
+	});
+	time_loop(sparse_motions, 1, gravity.view, gravity.view_checksum, [&]() {
+		registry.view<Motion, Gravity>().exclude<Spikeball>().each([](Entity, Motion& motion, Gravity&) {
+			motion.velocity[1] += 30.f;
+		});
+	});
+
+	time_loop(hash_motions, 0, integrate.hash, integrate.hash_checksum, [&]() {
+		for (unsigned int i = 0; i < hash.motions.components.size(); i++)
+		{
+			Motion& motion = hash.motions.components[i];
+			Entity e = hash.motions.entities[i];
+			motion.position[0] += motion.velocity[0] * 0.016f;
+			motion.position[1] += motion.velocity[1] * 0.016f;
+			if (hash.bullets.has(e) && !hash.eatables.has(e))
+				probed_bullets++;
+		}
+	});
+	time_loop(sparse_motions, 0, integrate.sparse, integrate.sparse_checksum, [&]() {
+		ComponentContainer<Motion>& motions = registry.get<Motion>();
+		for (unsigned int i = 0; i < motions.size(); i++)
+		{
+			Motion& motion = motions.components[i];
+			Entity e = motions.entities[i];
+			motion.position[0] += motion.velocity[0] * 0.016f;
+			motion.position[1] += motion.velocity[1] * 0.016f;
+			if (registry.get<Bullet>().has(e) && !registry.get<Eatable>().has(e))
+				probed_bullets++;
+		}
+	});
+	time_loop(sparse_motions, 0, integrate.view, integrate.view_checksum, [&]() {
+		registry.view<Motion>().each([](Entity, Motion& motion) {
+			motion.position[0] += motion.velocity[0] * 0.016f;
+			motion.position[1] += motion.velocity[1] * 0.016f;
+		});
+	});
+
+	std::vector<Entity> level = hash.motions.entities;
+	for (Entity e : level)
+		hash.remove_all_components_of(e);
+	registry.destroy_scope(level_scope);
+}
+
+static bool print_loop(const char* name, const LoopTimings& timings)
+{
+	printf("%-12s %10.2f %12.2f %10.2f %14.1f\n", name, timings.hash, timings.sparse, timings.view, timings.view_checksum);
+	return timings.hash_checksum == timings.view_checksum && timings.sparse_checksum == timings.view_checksum;
+}
+
+// Boxes that move a little every frame and bounce off the edges of a world that grows with their number
+struct MovingBox
+{
+	float x, y, half_width, half_height, velocity_x, velocity_y;
+};
+
+static constexpr int sweep_frames = 20;
+
+// The loop over all pairs the broadphase replaced, in the same order as the sorted pairs of SweepAndPrune
+static void find_pairs_all(const std::vector<SweepBounds>& boxes, std::vector<std::pair<unsigned int, unsigned int>>& pairs)
+{
+	pairs.clear();
+	for (unsigned int i = 0; i < boxes.size(); i++)
+		for (unsigned int j = i + 1; j < boxes.size(); j++)
+			if (boxes[i].left <= boxes[j].right && boxes[j].left <= boxes[i].right &&
+				boxes[i].top <= boxes[j].bot && boxes[j].top <= boxes[i].bot)
+				pairs.emplace_back(i, j);
+}
+
+// Move count boxes for a number of frames and find their pairs both ways, the times are per frame
+static bool run_sweep(int count, double& all_pairs_us, double& sweep_us, size_t& pair_count)
+{
+	std::mt19937 random(count);
+	std::uniform_real_distribution<float> unit(0.f, 1.f);
+	float world = 100.f * std::sqrt(float(count)); // about one box per 100x100 pixels, like a busy level
+	std::vector<MovingBox> moving(count);
+	for (MovingBox& box : moving)
+		box = { unit(random) * world, unit(random) * world, 5.f + unit(random) * 20.f, 5.f + unit(random) * 20.f,
+			unit(random) * 4.f - 2.f, unit(random) * 4.f - 2.f };
+
+	SweepAndPrune sweep_and_prune;
+	std::vector<SweepBounds> boxes(count);
+	std::vector<std::pair<unsigned int, unsigned int>> expected, pairs;
+	bool same = true;
+	all_pairs_us = sweep_us = 0;
+	pair_count = 0;
+	for (int frame = 0; frame < sweep_frames; frame++)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			MovingBox& box = moving[i];
+			box.x += box.velocity_x;
+			box.y += box.velocity_y;
+			if (box.x < 0.f || box.x > world)
+				box.velocity_x = -box.velocity_x;
+			if (box.y < 0.f || box.y > world)
+				box.velocity_y = -box.velocity_y;
+			boxes[i] = { box.x - box.half_width, box.x + box.half_width, box.y - box.half_height, box.y + box.half_height };
+		}
+		double start = now_us();
+		find_pairs_all(boxes, expected);
+		all_pairs_us += now_us() - start;
+		start = now_us();
+		sweep_and_prune.find_pairs(boxes, pairs);
+		sweep_us += now_us() - start;
+		same &= pairs == expected;
+		pair_count += pairs.size();
+	}
+	all_pairs_us /= sweep_frames;
+	sweep_us /= sweep_frames;
+	pair_count /= sweep_frames;
+	return same;
+}
+
+// Build the level, entities are interleaved like the tiles and characters of a map
+template <typename Insert>
+static void create_level(std::vector<Entity>& zombies, Insert insert)
+{
+	zombies.clear();
+	Entity::enter_scope(level_scope);
+	for (int i = 0; i < zombie_count + platform_count + falling_count; i++)
+	{
+		Entity e;
+		int kind = i % 15;
+		Motion motion;
+		motion.position[0] = float(i % 1000);
+		motion.position[1] = float(i / 1000);
+		if (kind < 10)
+		{
+			NormalZombie zombie;
+			zombie.is_alerted = i % 3 == 0;
+			insert(e, motion, true, &zombie, false);
+			zombies.push_back(e);
+		}
+		else
+			insert(e, motion, kind == 14, nullptr, kind < 14);
+	}
+	Entity::enter_scope(Entity::global_scope);
+}
+
+static Timings run_hash()
+{
+	Timings timings;
+	std::vector<Entity> zombies;
+	for (int run = 0; run < runs; run++)
+	{
+		HashRegistry registry;
+		double start = now_us();
+		create_level(zombies, [&](Entity e, const Motion& motion, bool gravity, const NormalZombie* zombie, bool platform) {
+			registry.motions.insert(e, motion);
+			if (gravity)
+				registry.gravities.insert(e, {});
+			if (zombie)
+				registry.zombies.insert(e, *zombie);
+			if (platform)
+				registry.platforms.insert(e, {});
+			registry.renderRequests.insert(e, {});
+		});
+		keep_best(timings.create, start);
+
+		start = now_us();
+		for (unsigned int i = 0; i < registry.zombies.components.size(); i++)
+		{
+			Entity e = registry.zombies.entities[i];
+			if (registry.gravities.has(e) && registry.motions.has(e))
+				move_zombie(registry.motions.get(e), registry.zombies.components[i]);
+		}
+		keep_best(timings.query, start);
+
+		start = now_us();
+		for (int i = 0; i < changed_count; i++)
+			registry.gravities.remove(zombies[i * 7]);
+		for (int i = 0; i < changed_count; i++)
+			registry.gravities.insert(zombies[i * 7], {});
+		keep_best(timings.toggle, start);
+
+		start = now_us();
+		for (int i = 0; i < changed_count; i++)
+			registry.remove_all_components_of(zombies[i * 11]);
+		keep_best(timings.kill, start);
+
+		timings.checksum = 0;
+		for (const Motion& motion : registry.motions.components)
+			timings.checksum += motion.position[1];
+
+		start = now_us();
+		std::vector<Entity> level = registry.motions.entities;
+		for (Entity e : level)
+			if (Entity::scope_of(e) == level_scope)
+				registry.remove_all_components_of(e);
+		Entity::release_scope(level_scope);
+		keep_best(timings.destroy, start);
+	}
+	return timings;
+}
+
+static Timings run_sparse()
+{
+	Timings timings;
+	std::vector<Entity> zombies;
+	SparseRegistry& registry = sparse_registry;
+	for (int run = 0; run < runs; run++)
+	{
+		double start = now_us();
+		create_level(zombies, [&](Entity e, const Motion& motion, bool gravity, const NormalZombie* zombie, bool platform) {
+			registry.get<Motion>().insert(e, motion);
+			if (gravity)
+				registry.get<Gravity>().emplace(e);
+			if (zombie)
+				registry.get<NormalZombie>().insert(e, *zombie);
+			if (platform)
+				registry.get<Platform>().emplace(e);
+			registry.get<RenderRequest>().insert(e, {});
+		});
+		keep_best(timings.create, start);
+
+		start = now_us();
+		registry.view<Motion, Gravity, NormalZombie>().each([](Entity, Motion& motion, Gravity&, NormalZombie& zombie) {
+			move_zombie(motion, zombie);
+		});
+		keep_best(timings.query, start);
+
+		start = now_us();
+		for (int i = 0; i < changed_count; i++)
+			registry.get<Gravity>().remove(zombies[i * 7]);
+		for (int i = 0; i < changed_count; i++)
+			registry.get<Gravity>().emplace(zombies[i * 7]);
+		keep_best(timings.toggle, start);
+
+		start = now_us();
+		for (int i = 0; i < changed_count; i++)
+			registry.remove_all_components_of(zombies[i * 11]);
+		keep_best(timings.kill, start);
+
+		timings.checksum = 0;
+		for (unsigned int i = 0; i < registry.get<Motion>().size(); i++)
+			timings.checksum += registry.get<Motion>().components[i].position[1];
+
+		start = now_us();
+		registry.destroy_scope(level_scope);
+		keep_best(timings.destroy, start);
+	}
+	return timings;
+}
+
+static Timings run_chunks()
+{
+	Timings timings;
+	std::vector<Entity> zombies;
+	for (int run = 0; run < runs; run++)
+	{
+		ChunkRegistry registry;
+		double start = now_us();
+		create_level(zombies, [&](Entity e, const Motion& motion, bool gravity, const NormalZombie* zombie, bool platform) {
+			registry.insert(e, motion);
+			if (gravity)
+				registry.insert(e, Gravity{});
+			if (zombie)
+				registry.insert(e, *zombie);
+			if (platform)
+				registry.insert(e, Platform{});
+			registry.insert(e, RenderRequest{});
+		});
+		keep_best(timings.create, start);
+
+		start = now_us();
+		registry.each<Motion, Gravity, NormalZombie>([](Entity, Motion& motion, Gravity&, NormalZombie& zombie) {
+			move_zombie(motion, zombie);
+		});
+		keep_best(timings.query, start);
+
+		// Every remove and insert moves the zombie to another archetype
+		start = now_us();
+		for (int i = 0; i < changed_count; i++)
+			registry.remove<Gravity>(zombies[i * 7]);
+		for (int i = 0; i < changed_count; i++)
+			registry.insert(zombies[i * 7], Gravity{});
+		keep_best(timings.toggle, start);
+
+		start = now_us();
+		for (int i = 0; i < changed_count; i++)
+			registry.remove_all_components_of(zombies[i * 11]);
+		keep_best(timings.kill, start);
+
+		timings.checksum = 0;
+		registry.each<Motion>([&](Entity, Motion& motion) { timings.checksum += motion.position[1]; });
+
+		start = now_us();
+		registry.destroy_scope(level_scope);
+		keep_best(timings.destroy, start);
+	}
+	return timings;
+}
+
+static void print(const char* name, const Timings& timings)
+{
+	printf("%-12s %10.1f %10.1f %10.1f %10.1f %10.1f %14.1f\n", name, timings.create, timings.query, timings.toggle,
+		timings.kill, timings.destroy, timings.checksum);
+}
+
+int main()
+{
+	std::vector<Entity> entities(op_count);
+	std::vector<Entity> shuffled;
+	for (int i = 0; i < op_count; i += 2)
+		shuffled.push_back(entities[i]);
+	std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(7));
+	printf("%d entities, every other one inserted, best of %d runs in us\n", op_count, runs);
+	printf("%-12s %10s %10s %10s %10s %14s\n", "container", "insert", "has", "get", "remove", "checksum");
+	OpTimings hash_ops = run_container_ops<HashContainer<Motion>>(entities, shuffled);
+	OpTimings sparse_ops = run_container_ops<ComponentContainer<Motion>>(entities, shuffled);
+	print_ops("hash map", hash_ops);
+	print_ops("sparse set", sparse_ops);
+	printf("\n");
+	if (hash_ops.checksum != sparse_ops.checksum)
+	{
+		fprintf(stderr, "The containers disagree\n");
+		return 1;
+	}
+
+	bool loops_agree = true;
+	const int view_levels[][2] = { { 3000, 50 }, { 3000, 1000 }, { 10000, 10000 } };
+	for (const int* level : view_levels)
+	{
+		LoopTimings gravity, integrate;
+		run_view_loops(level[0], level[1], gravity, integrate);
+		printf("%d platforms, %d falling items, best of %d runs in us\n", level[0], level[1], runs * 20);
+		printf("%-12s %10s %12s %10s %14s\n", "loop", "hash probe", "sparse probe", "view", "checksum");
+		loops_agree &= print_loop("gravity", gravity);
+		loops_agree &= print_loop("integrate", integrate);
+		printf("\n");
+	}
+	if (!loops_agree)
+	{
+		fprintf(stderr, "The loops disagree\n");
+		return 1;
+	}
+
+	printf("Broadphase of moving boxes, average of %d frames in us, the first one sorts from scratch\n", sweep_frames);
+	printf("%-12s %12s %12s %12s\n", "boxes", "all pairs", "sweep", "pairs/frame");
+	bool pairs_agree = true;
+	for (int count : { 1000, 2000, 5000, 10000 })
+	{
+		double all_pairs_us, sweep_us;
+		size_t pair_count;
+		pairs_agree &= run_sweep(count, all_pairs_us, sweep_us, pair_count);
+		printf("%-12d %12.1f %12.1f %12zu\n", count, all_pairs_us, sweep_us, pair_count);
+	}
+	printf("\n");
+	if (!pairs_agree)
+	{
+		fprintf(stderr, "The broadphases disagree\n");
+		return 1;
+	}
+
+	printf("%d zombies, %d platforms, %d falling items, best of %d runs in us\n", zombie_count, platform_count, falling_count, runs);
+	printf("%-12s %10s %10s %10s %10s %10s %14s\n", "backend", "create", "query", "toggle", "kill", "destroy", "checksum");
+	Timings hash = run_hash();
+	Timings sparse = run_sparse();
+	Timings chunks = run_chunks();
+	print("hash map", hash);
+	print("sparse set", sparse);
+	print("archetype", chunks);
+	// The sums run in different orders, they only agree up to rounding
+	double tolerance = std::abs(hash.checksum) * 1e-9;
+	if (std::abs(hash.checksum - sparse.checksum) > tolerance || std::abs(hash.checksum - chunks.checksum) > tolerance)
+	{
+		fprintf(stderr, "The backends disagree\n");
+		return 1;
+	}
+	return 0;
+}
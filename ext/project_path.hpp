@@ -2,4 +2,4 @@
 
 // Please don't change the content of this header, it is auto generated by CMAKE
 
-#define PROJECT_SOURCE_DIR "/Users/hanna/Desktop/Team7/"
+#define PROJECT_SOURCE_DIR "/root/repo/"
@@ -1,9 +1,12 @@
 // internal
 #include "ai_system.hpp"
+#include "frame_arena.hpp"
+#include "alloc_tracker.hpp"
 
 
 #include <queue>
 #include <unordered_map>
+#include <algorithm>
 #include <iostream>
 
 
@@ -15,9 +18,7 @@ AISystem::AISystem(){
 }
 
 AISystem::~AISystem() {
-	while (!prev_path.empty()) {
-		Vertex* v = prev_path.front();
-		prev_path.pop();
+	for (Vertex* v : prev_path) {
 		delete v;
 	}
 }
@@ -54,26 +55,15 @@ void updateZombieMemory(Entity entity, float elapsed_ms) {
 	}
 }
 
-// Helper function to reverse a queue
-std::queue<Vertex*> reverseQueue(std::queue<Vertex*>& reversedQueue) {
-	std::vector<Vertex*> temp;
-	while (!reversedQueue.empty()) {
-		temp.push_back(reversedQueue.front());
-		reversedQueue.pop();
-	}
-	for (int i = temp.size() - 1; i >= 0; i --) {
-		reversedQueue.push(temp[i]);
-	}
-	return reversedQueue;
-}
-
 // pathfinding using A*
-std::queue<Vertex*> findPathAStar(Vertex* start, Vertex* end) {
-	std::priority_queue<std::pair<Vertex*, float>> open;
-	std::unordered_map<Vertex*, Vertex*> parent;
-	std::unordered_map<Vertex*, float> g;
-	std::unordered_map<Vertex*, float> h;
-	std::unordered_map<Vertex*, float> f;
+// The search state and the returned path live in the frame arena, copy the path to keep it
+std::pmr::vector<Vertex*> findPathAStar(Vertex* start, Vertex* end) {
+	using OpenVertex = std::pair<Vertex*, float>;
+	std::priority_queue<OpenVertex, std::pmr::vector<OpenVertex>> open{ std::less<OpenVertex>(), std::pmr::vector<OpenVertex>(&frame_arena) };
+	std::pmr::unordered_map<Vertex*, Vertex*> parent(&frame_arena);
+	std::pmr::unordered_map<Vertex*, float> g(&frame_arena);
+	std::pmr::unordered_map<Vertex*, float> h(&frame_arena);
+	std::pmr::unordered_map<Vertex*, float> f(&frame_arena);
 	g[start] = 0.0f;
 	h[start] = findDistanceBetween({ start->x, start->y }, { end->x, end->y });
 	f[start] = g[start] + h[start];
@@ -84,13 +74,14 @@ std::queue<Vertex*> findPathAStar(Vertex* start, Vertex* end) {
 		open.pop();
 
 		if (best == end) {
-			std::queue<Vertex*> reversedPath;
+			std::pmr::vector<Vertex*> path(&frame_arena);
 			while (best->id != start->id) {
-				reversedPath.push(best);
+				path.push_back(best);
 				best = parent[best];
 			}
-			reversedPath.push(start);
-			return reverseQueue(reversedPath);
+			path.push_back(start);
+			std::reverse(path.begin(), path.end());
+			return path;
 		}
 
 		for (auto& adj : best->adjs) {
@@ -109,41 +100,39 @@ std::queue<Vertex*> findPathAStar(Vertex* start, Vertex* end) {
 	
 	// return empty queue if cannot find a path
 	printf("Cannot find a path from {%f, %f} to {%f, %f}\n", start->x, start->y, end->x, end->y);
-	return std::queue<Vertex*>();
+	return std::pmr::vector<Vertex*>(&frame_arena);
 }
 
 
 // Zombie will move according to the path
-void followPath(Motion& motion, std::queue<Vertex*> path,ACTION action, float speed, bool is_jumping) {
+void followPath(Motion& motion, const std::pmr::vector<Vertex*>& path,ACTION action, float speed, bool is_jumping) {
 	// precision controls how close between the target point and where the zombie stops
 	float precision = 20.f;
 	if (!path.empty()) {
 		//printf("Current location: {%f, %f}\n", motion.position.x, motion.position.y);
-		Vertex* v = path.front();
+		Vertex* v = path[0];
 		//printf("Target vertex {%f, %f} with id {%d}\n", v->x, v->y, v->id);
 		//printf("Current Action {%d}\n", action);
 		float current_h = findDistanceBetween(motion.position, { v->x, v->y });
-		path.pop();
 		// stop if it reaches destination
-		if (path.empty()) {
+		if (path.size() == 1) {
 			if (current_h <= precision) {
 				motion.velocity = { 0, 0 };
 			}
 			return;
 		}
 
-		Vertex* next = path.front();
+		Vertex* next = path[1];
 		float dist_to_next = findDistanceBetween(motion.position, { next->x, next->y });
 		float curr_to_next = findDistanceBetween({ v->x, v->y }, { next->x, next->y });
 
-		path.pop();
-		if (path.empty()) {
+		if (path.size() == 2) {
 			if (current_h <= precision) {
 				motion.velocity = { 0, 0 };
 			}
 			return;
 		}
-		Vertex* possible_jump = path.front();
+		Vertex* possible_jump = path[2];
 		//float dist_to_possible = findDistanceBetween(motion.position, { possible_jump->x, possible_jump->y });
 		//printf("dist to next: %f\n", dist_to_next);
 		// Go to next vertex if motion is between curr and next vertices
@@ -180,10 +169,12 @@ void AISystem::updateZombiePath(float elapsed_ms, int elapsed)
 {
 	
 	float memory = 2000.f;
-	for (Entity entity_z : registry.zombies.entities) {
+	OwningGroup<Motion, NormalZombie>& zombie_group = registry.zombieGroup;
+	for (unsigned int i = 0; i < zombie_group.size(); i++) {
 
-		NormalZombie& zombie = registry.zombies.get(entity_z);
-		Motion& motion_z = registry.motions.get(entity_z);
+		Entity entity_z = zombie_group.entity(i);
+		NormalZombie& zombie = zombie_group.get<NormalZombie>(i);
+		Motion& motion_z = zombie_group.get<Motion>(i);
 
 		if(zombie.is_dead){
 			motion_z.velocity = vec2(0,0);
@@ -295,6 +286,7 @@ void AISystem::updateZombiePath(float elapsed_ms, int elapsed)
 
 void AISystem::step(float elapsed_ms)
 {
+	AllocScope alloc_scope(ALLOC_SECTION::AI);
 	auto end = std::chrono::system_clock::now();
 	auto elasped = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
 	updateZombiePath(elapsed_ms, int(round(elasped)/100000));
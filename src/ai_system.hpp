@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <memory_resource>
 
 #include "tiny_ecs_registry.hpp"
 #include "common.hpp"
@@ -10,7 +11,8 @@ class AISystem
 {
 private:
 	std::chrono::system_clock::time_point start;
-	std::queue<Vertex*> prev_path = {};
+	// Kept across frames, so it's on the heap while the paths it's copied from are in the frame arena
+	std::pmr::vector<Vertex*> prev_path;
 
 	void updateZombiePath(float elapsed_ms, int elapsed);
 
@@ -0,0 +1,140 @@
+// internal
+#include "alloc_tracker.hpp"
+
+#ifdef ALLOC_TRACKING
+
+// stlib
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+// The counters are constant-initialized, so allocations before main are counted safely
+// The section is shared by all threads, the workers of a system count towards the system.
+static std::atomic<int> current_section{ (int)ALLOC_SECTION::OTHER };
+static std::atomic<uint64_t> section_counts[alloc_section_count];
+static std::atomic<uint64_t> section_bytes[alloc_section_count];
+static std::array<AllocStats, alloc_section_count> last_frame_stats;
+static unsigned int unsteady_frames = AllocTracker::warm_up_frames;
+static uint64_t frame = 0;
+
+static const char* section_names[alloc_section_count] = { "other", "world", "physics", "ai", "render" };
+
+const std::array<AllocStats, alloc_section_count>& AllocTracker::last_frame()
+{
+	return last_frame_stats;
+}
+
+void AllocTracker::count(size_t bytes)
+{
+	int section = current_section.load(std::memory_order_relaxed);
+	section_counts[section].fetch_add(1, std::memory_order_relaxed);
+	section_bytes[section].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+ALLOC_SECTION AllocTracker::enter(ALLOC_SECTION section)
+{
+	return (ALLOC_SECTION)current_section.exchange((int)section, std::memory_order_relaxed);
+}
+
+void AllocTracker::warm_up(unsigned int frames)
+{
+	if (frames > unsteady_frames)
+		unsteady_frames = frames;
+}
+
+void AllocTracker::end_frame()
+{
+	uint64_t total = 0;
+	for (int i = 0; i < alloc_section_count; i++)
+	{
+		last_frame_stats[i].count = section_counts[i].exchange(0, std::memory_order_relaxed);
+		last_frame_stats[i].bytes = section_bytes[i].exchange(0, std::memory_order_relaxed);
+		total += last_frame_stats[i].count;
+	}
+	frame++;
+	if (unsteady_frames > 0)
+	{
+		unsteady_frames--;
+		return;
+	}
+	if (total == 0)
+		return;
+
+	// Note, printf doesn't go through operator new, the report doesn't count towards the next frame
+	fprintf(stderr, "Steady-state frame %llu allocated:", (unsigned long long)frame);
+	for (int i = 0; i < alloc_section_count; i++)
+		if (last_frame_stats[i].count > 0)
+			fprintf(stderr, " %s %llu (%llu bytes)", section_names[i],
+				(unsigned long long)last_frame_stats[i].count, (unsigned long long)last_frame_stats[i].bytes);
+	fprintf(stderr, "\n");
+#ifdef ALLOC_ASSERT_STEADY
+	// Not an assert, it has to fail in release builds too
+	std::abort();
+#endif
+}
+
+// The replaceable global allocation functions, the array versions forward to these
+void* operator new(size_t size)
+{
+	AllocTracker::count(size);
+	void* p = std::malloc(size > 0 ? size : 1);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	std::free(p);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	AllocTracker::count(size);
+	size_t align = std::max((size_t)alignment, sizeof(void*));
+	void* p = nullptr;
+#ifdef _MSC_VER
+	p = _aligned_malloc(size > 0 ? size : 1, align);
+#else
+	if (posix_memalign(&p, align, size > 0 ? size : 1) != 0)
+		p = nullptr;
+#endif
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+#ifdef _MSC_VER
+	_aligned_free(p);
+#else
+	std::free(p);
+#endif
+}
+
+void operator delete(void* p, size_t, std::align_val_t alignment) noexcept
+{
+	operator delete(p, alignment);
+}
+
+#else
+
+static std::array<AllocStats, alloc_section_count> last_frame_stats;
+
+const std::array<AllocStats, alloc_section_count>& AllocTracker::last_frame()
+{
+	return last_frame_stats;
+}
+
+#endif
@@ -0,0 +1,70 @@
+#pragma once
+
+// stlib
+#include <array>
+#include <cstddef>
+#include <stdint.h>
+
+// The parts of a frame that heap allocations are counted towards, see AllocScope
+enum class ALLOC_SECTION
+{
+	OTHER = 0,
+	WORLD = OTHER + 1,
+	PHYSICS = WORLD + 1,
+	AI = PHYSICS + 1,
+	RENDER = AI + 1,
+	SECTION_COUNT = RENDER + 1
+};
+const int alloc_section_count = (int)ALLOC_SECTION::SECTION_COUNT;
+
+struct AllocStats
+{
+	uint64_t count = 0;
+	uint64_t bytes = 0;
+};
+
+// Heap allocation tracking, compiled in with ALLOC_TRACKING (cmake -DALLOC_TRACKING=ON)
+// The global operator new counts every allocation towards the current section. The game loop calls
+// end_frame() once per frame, which keeps the counts of the frame and reports when a steady-state frame
+// allocated anything. With ALLOC_ASSERT_STEADY the report is followed by an abort, in release builds too,
+// so allocation churn can't creep back into the main loop unnoticed.
+class AllocTracker
+{
+public:
+	// Frames after start-up or a level load that may allocate, e.g. while containers reach their peak size
+	static constexpr unsigned int warm_up_frames = 120;
+
+	// The counts of the last completed frame by section, all zero without ALLOC_TRACKING
+	static const std::array<AllocStats, alloc_section_count>& last_frame();
+
+#ifdef ALLOC_TRACKING
+	static void end_frame();
+	// The next frames are not steady, e.g. because a level was loaded
+	static void warm_up(unsigned int frames = warm_up_frames);
+
+	// Called by the global operator new
+	static void count(size_t bytes);
+	// Make section the current one, returns the previous
+	static ALLOC_SECTION enter(ALLOC_SECTION section);
+#else
+	static void end_frame() {}
+	static void warm_up(unsigned int = warm_up_frames) {}
+#endif
+};
+
+// Counts the allocations of a scope towards a section, e.g. at the start of a system's step
+// Scopes nest, the previous section is current again at the end of the scope.
+class AllocScope
+{
+#ifdef ALLOC_TRACKING
+	ALLOC_SECTION previous;
+public:
+	explicit AllocScope(ALLOC_SECTION section) : previous(AllocTracker::enter(section)) {}
+	~AllocScope() { AllocTracker::enter(previous); }
+#else
+public:
+	explicit AllocScope(ALLOC_SECTION) {}
+#endif
+	AllocScope(const AllocScope&) = delete;
+	AllocScope& operator=(const AllocScope&) = delete;
+};
@@ -119,3 +119,93 @@ bool Mesh::loadFromOBJFile(std::string obj_path, std::vector<ColoredVertex>& out
 
 	return true;
 }
+
+void save(Snapshot& snapshot, const NormalZombie& zombie)
+{
+	snapshot.write_value(zombie.is_alerted);
+	snapshot.write_array(zombie.walking_bound);
+	snapshot.write_value(zombie.walking_range);
+	snapshot.write_value(zombie.sensing_range);
+	snapshot.write_value(zombie.face);
+	snapshot.write_value(zombie.memory);
+	snapshot.write_value(zombie.alerted_speed);
+	snapshot.write_value(zombie.is_jumping);
+	snapshot.write_value(zombie.is_dead);
+	snapshot.write_value(zombie.death_counter);
+}
+
+void load(Snapshot& snapshot, NormalZombie& zombie)
+{
+	zombie.is_alerted = snapshot.read_value<int>();
+	snapshot.read_array(zombie.walking_bound);
+	zombie.walking_range = snapshot.read_value<float>();
+	zombie.sensing_range = snapshot.read_value<vec2>();
+	zombie.face = snapshot.read_value<DIRECTION>();
+	zombie.memory = snapshot.read_value<float>();
+	zombie.alerted_speed = snapshot.read_value<float>();
+	zombie.is_jumping = snapshot.read_value<bool>();
+	zombie.is_dead = snapshot.read_value<bool>();
+	zombie.death_counter = snapshot.read_value<float>();
+}
+
+void save(Snapshot& snapshot, const Text& text)
+{
+	snapshot.write_string(text.text);
+	snapshot.write_value(text.color);
+}
+
+void load(Snapshot& snapshot, Text& text)
+{
+	text.text = snapshot.read_string();
+	text.color = snapshot.read_value<vec3>();
+}
+
+void save(Snapshot& snapshot, const TextBlock& block)
+{
+	snapshot.write_string(block.text);
+}
+
+void load(Snapshot& snapshot, TextBlock& block)
+{
+	block.text = snapshot.read_string();
+}
+
+// The elements of a queue, which std::queue keeps in its protected container
+// Reading them in place keeps capturing a running dialog from copying its queues.
+template <typename Queue>
+static const typename Queue::container_type& queue_items(const Queue& queue)
+{
+	struct Items : Queue
+	{
+		static const typename Queue::container_type& of(const Queue& queue) { return queue.*(&Items::c); }
+	};
+	return Items::of(queue);
+}
+
+void save(Snapshot& snapshot, const Speech& speech)
+{
+	snapshot.write_value((uint32_t)speech.texts.size());
+	for (const std::pair<Entity, std::string>& text : queue_items(speech.texts))
+	{
+		snapshot.write_value(text.first);
+		snapshot.write_string(text.second);
+	}
+	snapshot.write_value((uint32_t)speech.timer.size());
+	for (float time : queue_items(speech.timer))
+		snapshot.write_value(time);
+	snapshot.write_value(speech.counter_ms);
+}
+
+void load(Snapshot& snapshot, Speech& speech)
+{
+	speech.texts = {};
+	for (uint32_t count = snapshot.read_value<uint32_t>(); count > 0; count--)
+	{
+		Entity speaker = snapshot.read_value<Entity>();
+		speech.texts.emplace(speaker, snapshot.read_string());
+	}
+	speech.timer = {};
+	for (uint32_t count = snapshot.read_value<uint32_t>(); count > 0; count--)
+		speech.timer.push(snapshot.read_value<float>());
+	speech.counter_ms = snapshot.read_value<float>();
+}
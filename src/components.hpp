@@ -44,6 +44,11 @@ struct Platform
 	vec2 scale = {10, 10};
 };
 
+// The sprite of a single map tile of a platform, the collisions use the merged Platform boxes instead
+struct PlatformTile
+{
+};
+
 struct Door
 {
 	bool is_open = false;
@@ -93,7 +98,7 @@ struct Collision
 {
 	// Note, the first object is stored in the ECS container.entities
 	Entity other; // the second object involved in the collision
-	Collision(Entity &other) { this->other = other; };
+	Collision(Entity &other) : other(other) {};
 };
 
 // Data structure for toggling debug mode
@@ -352,3 +357,13 @@ struct RenderRequest
 	EFFECT_ASSET_ID used_effect = EFFECT_ASSET_ID::EFFECT_COUNT;
 	GEOMETRY_BUFFER_ID used_geometry = GEOMETRY_BUFFER_ID::GEOMETRY_COUNT;
 };
+
+// Snapshot support of the components that aren't trivially copyable, see ComponentContainer::snapshot
+void save(Snapshot& snapshot, const NormalZombie& zombie);
+void load(Snapshot& snapshot, NormalZombie& zombie);
+void save(Snapshot& snapshot, const Text& text);
+void load(Snapshot& snapshot, Text& text);
+void save(Snapshot& snapshot, const TextBlock& block);
+void load(Snapshot& snapshot, TextBlock& block);
+void save(Snapshot& snapshot, const Speech& speech);
+void load(Snapshot& snapshot, Speech& speech);
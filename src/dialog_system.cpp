@@ -93,9 +93,7 @@ Speech&  DialogSystem::createTutorialSpeech(Entity speaker, std::string text, fl
 	if (registry.speech.has(registry.players.entities[0]))
 	{
 		Speech& dialog = registry.speech.get(registry.players.entities[0]);
-		std::pair<Entity, std::string> sentence;
-		sentence.first = speaker;
-		sentence.second = text;
+		std::pair<Entity, std::string> sentence(speaker, text);
 		dialog.texts.push(sentence);
 		dialog.timer.push(time);
 		dialog.counter_ms = time;
@@ -104,9 +102,7 @@ Speech&  DialogSystem::createTutorialSpeech(Entity speaker, std::string text, fl
 	else
 	{
 		Speech& dialog = registry.speech.emplace(registry.players.entities[0]);
-		std::pair<Entity, std::string> sentence;
-		sentence.first = speaker;
-		sentence.second = text;
+		std::pair<Entity, std::string> sentence(speaker, text);
 		dialog.texts.push(sentence);
 		dialog.timer.push(time);
 		dialog.counter_ms = time;
@@ -127,9 +123,7 @@ void DialogSystem::createSpeech(Entity speaker, std::string text, float time) {
 	if (registry.speech.has(registry.players.entities[0]))
 	{
 		Speech& dialog = registry.speech.get(registry.players.entities[0]);
-		std::pair<Entity, std::string> sentence;
-		sentence.first = speaker;
-		sentence.second = text;
+		std::pair<Entity, std::string> sentence(speaker, text);
 		dialog.texts.push(sentence);
 		dialog.timer.push(time);
 		dialog.counter_ms = time;
@@ -137,9 +131,7 @@ void DialogSystem::createSpeech(Entity speaker, std::string text, float time) {
 	else
 	{
 		Speech& dialog = registry.speech.emplace(registry.players.entities[0]);
-		std::pair<Entity, std::string> sentence;
-		sentence.first = speaker;
-		sentence.second = text;
+		std::pair<Entity, std::string> sentence(speaker, text);
 		dialog.texts.push(sentence);
 		dialog.timer.push(time);
 		dialog.counter_ms = time;
@@ -0,0 +1,39 @@
+// internal
+#include "frame_arena.hpp"
+
+FrameArena frame_arena;
+
+static size_t blocks_for(size_t bytes)
+{
+	return (bytes + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+}
+
+FrameArena::FrameArena(size_t capacity)
+	: buffer(new std::max_align_t[blocks_for(capacity)])
+	, capacity(blocks_for(capacity) * sizeof(std::max_align_t))
+{
+}
+
+void FrameArena::reset()
+{
+	// Grow the buffer to what the frame asked for, with some headroom
+	if (used > capacity)
+	{
+		capacity = blocks_for(used + used / 2) * sizeof(std::max_align_t);
+		buffer.reset(new std::max_align_t[capacity / sizeof(std::max_align_t)]);
+	}
+	overflow.release();
+	used = 0;
+}
+
+void* FrameArena::do_allocate(size_t bytes, size_t alignment)
+{
+	// The buffer is aligned for any fundamental type, over-aligned types go to the heap
+	if (alignment > alignof(std::max_align_t))
+		return overflow.allocate(bytes, alignment);
+	size_t start = (used + alignment - 1) / alignment * alignment;
+	used = start + bytes;
+	if (used <= capacity)
+		return reinterpret_cast<unsigned char*>(buffer.get()) + start;
+	return overflow.allocate(bytes, alignment);
+}
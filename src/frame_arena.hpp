@@ -0,0 +1,34 @@
+#pragma once
+
+// stlib
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+// A bump allocator for data that only lives during the current frame, e.g. a path and its search state
+// Containers use it through std::pmr, e.g. std::pmr::vector<Vertex*> path(&frame_arena). Deallocating is a
+// no-op, the memory of the whole frame is handed back by reset(). If a frame needs more than the buffer holds,
+// the rest comes from the heap and the buffer grows to fit at the next reset, so steady-state frames don't
+// allocate. Note, it's not thread safe, only the main thread uses it.
+class FrameArena : public std::pmr::memory_resource
+{
+	std::unique_ptr<std::max_align_t[]> buffer;
+	size_t capacity = 0;
+	size_t used = 0; // bytes requested this frame, including the ones that didn't fit
+	std::pmr::monotonic_buffer_resource overflow;
+
+public:
+	explicit FrameArena(size_t capacity = 64 * 1024);
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	// Free everything allocated since the last reset, called after every simulation step by the game loop
+	void reset();
+
+protected:
+	void* do_allocate(size_t bytes, size_t alignment) override;
+	void do_deallocate(void*, size_t, size_t) override {}
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+};
+
+extern FrameArena frame_arena;
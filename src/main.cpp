@@ -3,6 +3,7 @@
 #include <gl3w.h>
 
 // stlib
+#include <algorithm>
 #include <chrono>
 
 // internal
@@ -12,10 +13,17 @@
 #include "dialog_system.hpp"
 
 #include "ai_system.hpp"
+#include "frame_arena.hpp"
+#include "alloc_tracker.hpp"
 #include <iostream>
 
 using Clock = std::chrono::high_resolution_clock;
 
+// The simulation advances in fixed steps of 1 / simulation_hz seconds, however long a frame takes
+const float simulation_hz = 60.f;
+// The most steps a frame runs, after a longer hitch the game slows down instead of catching up all at once
+const int max_substeps = 5;
+
 
 
 // Entry point
@@ -47,7 +55,9 @@ int main()
 	world.init(&renderer,&dialog);
 	
 
-	// variable timestep loop
+	// fixed timestep loop, the frames draw in between the last two steps
+	const float step_ms = 1000.f / simulation_hz;
+	float accumulated_ms = 0.f;
 	auto t = Clock::now();
 	while (!world.is_over()) {
 		// Processes system messages, if this wasn't present the window would become unresponsive
@@ -60,14 +70,29 @@ int main()
 		t = now;
 
 
-		world.step(elapsed_ms);
-		if (!world.is_paused()) {
-			physics.step(elapsed_ms);
-			ai.step(elapsed_ms);
+		accumulated_ms = std::min(accumulated_ms + elapsed_ms, max_substeps * step_ms);
+		while (accumulated_ms >= step_ms && !world.is_over()) {
+			renderer.storePreviousMotions();
+
+			// Structural changes the systems recorded are applied after each of them
+			world.step(step_ms);
+			registry.flush_commands();
+			if (!world.is_paused()) {
+				physics.step(step_ms);
+				ai.step(step_ms);
+				registry.flush_commands();
+			}
+			world.handle_collisions();
+			// Only the steps use the arena, resetting it after each keeps a frame with several of them from growing it
+			frame_arena.reset();
+			accumulated_ms -= step_ms;
 		}
-		world.handle_collisions();
-		
-		renderer.draw();
+
+		renderer.draw(accumulated_ms / step_ms);
+		world.countFrame(elapsed_ms);
+		registry.clear_updated();
+		registry.reset_counters();
+		AllocTracker::end_frame();
 		float ms_to_sleep = 1000 /60 - elapsed_ms;
 	}
 
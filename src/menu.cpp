@@ -29,14 +29,12 @@ std::vector<vec2> arrangeTextStart(int num) {
 }
 
 void renderPauseMenu() {
-	Entity resume, save, load, quit, help;
-	std::vector<Entity> elements = {Entity(), Entity(), Entity(), Entity(), Entity()};
 	std::vector<std::string> texts = { "Resume", "HELP", "Save", "Load", "QUIT" };
 	std::vector<MENU_FUNC> funcs = { MENU_FUNC::RESUME, MENU_FUNC::HELP, MENU_FUNC::SAVE, MENU_FUNC::LOAD, MENU_FUNC::QUIT };
 	Entity background = createMenuBackground({ window_width_px / 2, window_height_px / 2 }, { 300, 600 });
 	auto& menu1 = registry.menus.emplace(background);
-	std::vector<vec2> pos = arrangeText(elements.size());
-	for (int i = 0; i < elements.size(); i++) {
+	std::vector<vec2> pos = arrangeText(texts.size());
+	for (int i = 0; i < texts.size(); i++) {
 		Entity entity = createText(pos[i], 0.8, {1, 1, 1}, texts[i]);
 		auto& menu2 = registry.menus.emplace(entity);
 		menu2.func = funcs[i];
@@ -44,14 +42,12 @@ void renderPauseMenu() {
 }
 
 void renderStartMenu() {
-	Entity start, load, tutorial, quit;
-	std::vector<Entity> elements = {Entity(), Entity(), Entity(), Entity()};
 	std::vector<std::string> texts = { "New game", "Load game", "Tutorial", "QUIT" };
 	std::vector<MENU_FUNC> funcs = { MENU_FUNC::START, MENU_FUNC::LOAD, MENU_FUNC::TUTORIAL, MENU_FUNC::QUIT };
 	Entity background = createBackgroundImage(TEXTURE_ASSET_ID::BACKGROUNDSTART);
 	auto& menu1 = registry.menus.emplace(background);
-	std::vector<vec2> pos = arrangeTextStart(elements.size());
-	for (int i = 0; i < elements.size(); i++) {
+	std::vector<vec2> pos = arrangeTextStart(texts.size());
+	for (int i = 0; i < texts.size(); i++) {
 		Entity entity = createText(pos[i], 0.7, {1, 1, 1}, texts[i]);
 		auto& menu2 = registry.menus.emplace(entity);
 		menu2.func = funcs[i];
@@ -59,9 +55,11 @@ void renderStartMenu() {
 }
 
 void clearMenu() {
+	// Destroyed at the flush, removing right away would skip entities of the container being iterated
 	for (Entity entity : registry.menus.entities) {
-		registry.remove_all_components_of(entity);
+		registry.commands().destroy(entity);
 	}
+	registry.flush_commands();
 }
 
 
@@ -194,31 +192,32 @@ bool checkSavingValid()
 }
 
 bool loadGame(RenderSystem* renderer, bool& has_key, int& hp_count, int& bullet_count, int& current_level) {
-	// clear all existing characters
+	// clear all existing characters, at the flush so the loops don't skip entities
 	for (Entity entity : registry.players.entities) {
-		registry.remove_all_components_of(entity);
+		registry.commands().destroy(entity);
 	}
 	for (Entity entity : registry.zombies.entities) {
-		registry.remove_all_components_of(entity);
+		registry.commands().destroy(entity);
 	}
 	for (Entity entity : registry.keys.entities) {
-		registry.remove_all_components_of(entity);
+		registry.commands().destroy(entity);
 	}
 	for (Entity entity : registry.foods.entities) {
-		registry.remove_all_components_of(entity);
+		registry.commands().destroy(entity);
 	}
 	for (Entity entity : registry.bullets.entities) {
-		registry.remove_all_components_of(entity);
+		registry.commands().destroy(entity);
 	}
 	for (Entity entity : registry.hearts.entities) {
-		registry.remove_all_components_of(entity);
+		registry.commands().destroy(entity);
 	}
 	for (Entity entity : registry.smallKeys.entities) {
-		registry.remove_all_components_of(entity);
+		registry.commands().destroy(entity);
 	}
 	for (Entity entity : registry.smallBullets.entities) {
-		registry.remove_all_components_of(entity);
+		registry.commands().destroy(entity);
 	}
+	registry.flush_commands();
 	std::fstream file;
 	file.open(SAVE_PATH);
 
@@ -302,9 +301,7 @@ bool handleButtonEvents(Entity entity, RenderSystem* renderer, GLFWwindow* windo
 		glfwSetWindowShouldClose(window, true);
 	}
 	else if (me.func == MENU_FUNC::HELP) {
-		for (Entity entity : registry.menus.entities) {
-			registry.remove_all_components_of(entity);
-		}
+		clearMenu();
 		Entity entity = createHelpInfo(renderer, vec2(window_width_px - 515, window_height_px - 350));
 	}
 	else if (me.func == MENU_FUNC::START) {
@@ -1,6 +1,8 @@
 // internal
 #include "physics_system.hpp"
 #include "world_init.hpp"
+#include "alloc_tracker.hpp"
+#include "tile_grid.hpp"
 #include <iostream>
 
 vec2 previous_position = {};
@@ -124,7 +126,7 @@ bool check_line_intersects(vec2 point1, vec2 point2, vec2 point3, vec2 point4)
 	return false;
 }
 
-void collision_resolve(Motion& motion, vec2 prev_pos, std::vector<int> dir, Motion& motion2)
+void collision_resolve(Motion& motion, vec2 prev_pos, const std::array<int, 5>& dir, Motion& motion2)
 {
 
 	if (dir[0] == 1) {
@@ -145,7 +147,7 @@ void collision_resolve(Motion& motion, vec2 prev_pos, std::vector<int> dir, Moti
 	
 }
 // checks mesh based collision between player mesh and other objects
-std::vector<int> collides_with_mesh(const Motion& motion, const Motion& mesh_motion, float step_secs, const Mesh& meshPtrs) {
+std::array<int, 5> collides_with_mesh(const Motion& motion, const Motion& mesh_motion, float step_secs, const Mesh& meshPtrs) {
 
 	
 	vec2 pos1 = motion.position;
@@ -171,7 +173,7 @@ std::vector<int> collides_with_mesh(const Motion& motion, const Motion& mesh_mot
 	double meshPosY = mesh_motion.position.y;
 
 	auto& vertices = meshPtrs.vertices;
-	std::vector<int> collision_dirs = {0, 0, 0, 0, 0};
+	std::array<int, 5> collision_dirs = {0, 0, 0, 0, 0};
 	for (uint i = 0; i < vertices.size() - 1; i++)
 	{
 		
@@ -324,6 +326,17 @@ bool collides(const Motion& motion1, const Motion& motion2, float step_secs, DIR
 
 
 }
+// The area the collision checks of a motion look at, its box now and where collides() predicts it
+// The mesh vertices are normalized to the box, with 1px more for their rounding.
+SweepBounds collision_bounds(const Motion& motion, float step_secs)
+{
+	vec2 half = get_bounding_box(motion) / 2.f;
+	vec2 moved = motion.velocity * step_secs;
+	return {
+		motion.position.x - half.x + min(moved.x, 0.f) - 1, motion.position.x + half.x + max(moved.x, 0.f) + 1,
+		motion.position.y - half.y + min(moved.y, 0.f) - 1, motion.position.y + half.y + max(moved.y, 0.f) + 1 };
+}
+
 // Helper for changing spikeball directions
 //dir :: next collision direction (not movement direction, eg: collision bot will be moving left or right)
 //currentDir :: current collision direction
@@ -365,6 +378,7 @@ void setNewSpikeMotion(uint dir, uint currentDir, Motion& ballmotion, Spikeball&
 
 void PhysicsSystem::step(float elapsed_ms)
 {
+	AllocScope alloc_scope(ALLOC_SECTION::PHYSICS);
 	//previous position before moving
 	auto& players = registry.players;
 	for (uint i = 0; i < players.size(); i++) {
@@ -406,30 +420,21 @@ void PhysicsSystem::step(float elapsed_ms)
 
 	// ------------------- Gravity system -------------------------------------
 	// Check gravity first so we can finalize yspeed
-	float gravity = 30;
+	// The speed gained per second, it was tuned as 30 per frame at 60 fps
 	float step_seconds = elapsed_ms / 1000.f;
-	ComponentContainer<Gravity>& gravity_container = registry.gravities;
-	for (uint i = 0; i < gravity_container.size(); i++)
-	{
-		Entity entity = gravity_container.entities[i];
-		if (!registry.spikeballs.has(entity)) {
-			if (!registry.players.has(entity)) {
-				if (registry.motions.has(entity)) {
-					Motion& motion = registry.motions.get(entity);
-					motion.velocity[1] += gravity;
-					if (motion.velocity.y <= 9999) {
-						motion.velocity[1] += gravity;
-					}
-				}
-			}
-			else {
-				if (registry.players.get(entity).standing == false) {
-					Motion& motion = registry.motions.get(entity);
-					motion.velocity[1] += gravity;
-				}
-			}
+	float gravity = 1800 * step_seconds;
+	// Players only fall while they aren't standing on something, spikeballs follow their own path
+	registry.view<Motion, Gravity>().exclude<Spikeball, Player>().each([&](Entity entity, Motion& motion, Gravity&) {
+		motion.velocity[1] += gravity;
+		if (motion.velocity.y <= 9999) {
+			motion.velocity[1] += gravity;
 		}
-	}
+	});
+	registry.view<Motion, Gravity, Player>().exclude<Spikeball>().each([&](Entity entity, Motion& motion, Gravity&, Player& player) {
+		if (player.standing == false) {
+			motion.velocity[1] += gravity;
+		}
+	});
 
 	
 
@@ -439,21 +444,10 @@ void PhysicsSystem::step(float elapsed_ms)
 
 	// -------------------------- Step motion objects --------------------------
 	// having entities move at different speed based on the machine.
-	for (uint i = 0; i < motion_container.size(); i++)
-	{
-		Motion& motion = motion_container.components[i];
-		Entity entity = motion_container.entities[i];
+	registry.parallel_each<Motion>([&](Entity entity, Motion& motion) {
 		motion.position[0] += motion.velocity[0] * step_seconds;
 		motion.position[1] += motion.velocity[1] * step_seconds;
-
-
-		//remove bullet
-		if (registry.bullets.has(entity) && !registry.eatables.has(entity)) {
-
-			//registry.collisions.emplace_with_duplicates(entity, entity);
-		}
-
-	}
+	});
 
 	// ------------------------------- Debugging ---------------------------------
 	
@@ -624,14 +618,18 @@ void PhysicsSystem::step(float elapsed_ms)
 		Motion cornermot = { {-1234,-1} };
 
 		Motion platmot = {};
-		for (uint j = 0; j < plats.size(); j++) {
-			Entity& plat = plats.entities[j];
-			
-			Motion pmotion = { registry.platforms.get(plat).position, 0, {0,0}, registry.platforms.get(plat).scale };
+		// A ball that touches no tile of the level can't hit its platforms, the corner checks look 2px further
+		SweepBounds reach = collision_bounds(ballmotion, step_seconds);
+		if (level_tiles.overlaps({ reach.left - 2, reach.top - 2 }, { reach.right + 2, reach.bot + 2 }))
+			platform_grid.query(ballmotion.position - vec2(200, 200), ballmotion.position + vec2(200, 200), nearby_platforms);
+		else
+			nearby_platforms.clear();
+		for (uint j : nearby_platforms) {
+			Motion pmotion = { plats.components[j].position, 0, {0,0}, plats.components[j].scale };
 			double platX = pmotion.position.x;
 			double platY = pmotion.position.y;
 			
-			if (abs(platX - ballX) < 200  && abs(platY - ballY) < 200)
+			if (abs(platX - ballX) < 200 + abs(pmotion.scale.x) / 2 && abs(platY - ballY) < 200 + abs(pmotion.scale.y) / 2)
 			{
 				
 
@@ -771,23 +769,34 @@ void PhysicsSystem::step(float elapsed_ms)
 
 	// ---------------------------------- Collision checking ----------------------------------
 	// Check for collisions between all moving entities and platforms
+	// Only the platforms in the grid cells around an entity can pass the distance check, see PlatformGrid
+	// Platforms and zombies have their own segments in motions (see ECSRegistry), which saves the lookups
+	uint platforms_begin = registry.platformGroup.begin(), platforms_end = registry.platformGroup.end();
+	uint zombies_begin = registry.zombieGroup.begin(), zombies_end = registry.zombieGroup.end();
 	for (uint i = 0; i < motion_container.size(); i++)
 	{
 		Motion& motion = motion_container.components[i];
 		Entity& entity = motion_container.entities[i];
-		// only check platform collision if current motion is not a platform
-		if (!registry.platforms.has(registry.motions.entities[i])) {
+		bool is_zombie = i >= zombies_begin && i < zombies_end;
+		// only check platform collision if current motion is not a platform or the sprite of a platform tile
+		if ((i < platforms_begin || i >= platforms_end) && !registry.platformTiles.has(entity)) {
 			bool collide = false;
-			for (uint p = 0; p < plat_container.size(); p++)
+			// Entities that touch no tile of the level can't collide with its platforms
+			SweepBounds reach = collision_bounds(motion, step_seconds);
+			if (level_tiles.overlaps({ reach.left, reach.top }, { reach.right, reach.bot }))
+				platform_grid.query(motion.position - vec2(200, 200), motion.position + vec2(200, 200), nearby_platforms);
+			else
+				nearby_platforms.clear();
+			for (uint p : nearby_platforms)
 			{
 				Platform& plat = plat_container.components[p];
 				Motion motion_p = { plat.position, 0, {0,0}, plat.scale };
-				if (abs(motion_p.position.x - motion.position.x) < 200 && abs(motion_p.position.y - motion.position.y) < 200 && !registry.golds.has(registry.motions.entities[i]) && !registry.fireballs.has(registry.motions.entities[i]) && !registry.spikeballs.has(registry.motions.entities[i])) {
-					// make collision checking more efficient, only check close platforms
+				if (abs(motion_p.position.x - motion.position.x) < 200 + abs(motion_p.scale.x) / 2 && abs(motion_p.position.y - motion.position.y) < 200 + abs(motion_p.scale.y) / 2 && !registry.has_any<Gold, Fireball, Spikeball>(entity)) {
+					// make collision checking more efficient, only check close platforms, measured from their sides as merged platforms can be long
 					// mesh collision				
 					if (registry.players.has(entity)) {
 						Player& player = registry.players.get(entity);
-						std::vector<int> collide_dir = collides_with_mesh(motion_p, motion, step_seconds, *registry.meshPtrs.get(motion_container.entities[i]));
+						std::array<int, 5> collide_dir = collides_with_mesh(motion_p, motion, step_seconds, *registry.meshPtrs.get(motion_container.entities[i]));
 						if (collide_dir[4] == 1) {
 							collide = true;
 							collision_resolve(motion, previous_position, collide_dir, motion_p);
@@ -822,7 +831,7 @@ void PhysicsSystem::step(float elapsed_ms)
 						}
 						if (collides(motion, motion_p, step_seconds, DIRECTION::LEFT)) {
 							
-							if (registry.zombies.has(entity)) {
+							if (is_zombie) {
 								motion.position.x = motion_p.position.x + abs(motion_p.scale.x) / 2 + abs(motion.scale.x) / 2;
 								motion.velocity.x *= -1;
 							
@@ -836,7 +845,7 @@ void PhysicsSystem::step(float elapsed_ms)
 						}
 						if (collides(motion, motion_p, step_seconds, DIRECTION::RIGHT)) {
 							
-							if (registry.zombies.has(entity)) {
+							if (is_zombie) {
 								motion.position.x = motion_p.position.x + abs(motion_p.scale.x) / 2 + abs(motion.scale.x) / 2;
 								motion.velocity.x *= -1;
 							
@@ -850,48 +859,6 @@ void PhysicsSystem::step(float elapsed_ms)
 					}
 				}
 			}
-			// ----------------------------- motion vs non platform collision checking ---------------------------------------
-			// note starting j at i+1 to compare all (i,j) pairs only once (and to not compare with itself)
-			for (uint j = i + 1; j < motion_container.components.size(); j++)
-			{
-				if (!registry.platforms.has(motion_container.entities[j])) {
-					Motion& motion_j = motion_container.components[j];
-					if (registry.players.has(entity))
-					{
-						if (collides_with_mesh(motion_j, motion, step_seconds, *registry.meshPtrs.get(motion_container.entities[i]))[4] == 1) {
-							Entity entity_j = motion_container.entities[j];
-							if ((!registry.collisions.has(entity) || !registry.collisions.has(entity_j))) {
-								registry.collisions.emplace_with_duplicates(entity, entity_j);
-								registry.collisions.emplace_with_duplicates(entity_j, entity);
-							}
-						}
-					}
-					else if (registry.players.has(motion_container.entities[j]))
-					{
-						if (collides_with_mesh(motion, motion_j, step_seconds, *registry.meshPtrs.get(motion_container.entities[j]))[4] == 1) {
-							Entity entity_j = motion_container.entities[j];
-							if ((!registry.collisions.has(entity) || !registry.collisions.has(entity_j))) {
-								registry.collisions.emplace_with_duplicates(entity, entity_j);
-								registry.collisions.emplace_with_duplicates(entity_j, entity);
-							}
-						}
-					}
-					else {
-						if (collides(motion, motion_j, step_seconds))
-						{
-							Entity entity_j = motion_container.entities[j];
-							
-							// Create a collisions event
-							// We are abusing the ECS system a bit in that we potentially insert muliple collisions for the same entity
-							if ((!registry.collisions.has(entity) || !registry.collisions.has(entity_j))) {
-								registry.collisions.emplace_with_duplicates(entity, entity_j);
-								registry.collisions.emplace_with_duplicates(entity_j, entity);
-							}
-						}
-					}
-				}
-			}
-
 			if (registry.players.has(entity) && (collide == false)) {
 
 				registry.players.get(entity).standing = 0;
@@ -901,31 +868,78 @@ void PhysicsSystem::step(float elapsed_ms)
 		}
 	}
 
-	// ------------------------------------- Boundary checking -------------------------------------
-	// Check boundaries
-	auto& motion_registry = registry.motions;
-	for (uint i = 0; i < motion_registry.size(); i++) {
-		Entity entity = motion_container.entities[i];
-		// skip boundary checks for texts
-		if (registry.texts.has(entity)) {
+	// ----------------------------- motion vs non platform collision checking ---------------------------------------
+	// The sweep finds the pairs whose bounds overlap, sorted like the loop over all (i, j) pairs with i < j it replaces
+	sweep_bounds.resize(motion_container.size());
+	for (uint i = 0; i < motion_container.size(); i++)
+	{
+		if ((i >= platforms_begin && i < platforms_end) || registry.platformTiles.has(motion_container.entities[i])) {
+			sweep_bounds[i] = SweepBounds::none();
 			continue;
 		}
-		Motion& motion = motion_registry.components[i];
+		sweep_bounds[i] = collision_bounds(motion_container.components[i], step_seconds);
+	}
+	sweep_and_prune.find_pairs(sweep_bounds, sweep_pairs);
+	for (const auto& pair : sweep_pairs)
+	{
+		uint i = pair.first, j = pair.second;
+		Motion& motion = motion_container.components[i];
+		Entity& entity = motion_container.entities[i];
+		Motion& motion_j = motion_container.components[j];
+		if (registry.players.has(entity))
+		{
+			if (collides_with_mesh(motion_j, motion, step_seconds, *registry.meshPtrs.get(motion_container.entities[i]))[4] == 1) {
+				Entity entity_j = motion_container.entities[j];
+				if ((!registry.collisions.has(entity) || !registry.collisions.has(entity_j))) {
+					registry.collisions.emplace_with_duplicates(entity, entity_j);
+					registry.collisions.emplace_with_duplicates(entity_j, entity);
+				}
+			}
+		}
+		else if (registry.players.has(motion_container.entities[j]))
+		{
+			if (collides_with_mesh(motion, motion_j, step_seconds, *registry.meshPtrs.get(motion_container.entities[j]))[4] == 1) {
+				Entity entity_j = motion_container.entities[j];
+				if ((!registry.collisions.has(entity) || !registry.collisions.has(entity_j))) {
+					registry.collisions.emplace_with_duplicates(entity, entity_j);
+					registry.collisions.emplace_with_duplicates(entity_j, entity);
+				}
+			}
+		}
+		else {
+			if (collides(motion, motion_j, step_seconds))
+			{
+				Entity entity_j = motion_container.entities[j];
+				
+				// Create a collisions event
+				// We are abusing the ECS system a bit in that we potentially insert muliple collisions for the same entity
+				if ((!registry.collisions.has(entity) || !registry.collisions.has(entity_j))) {
+					registry.collisions.emplace_with_duplicates(entity, entity_j);
+					registry.collisions.emplace_with_duplicates(entity_j, entity);
+				}
+			}
+		}
+	}
+
+	// ------------------------------------- Boundary checking -------------------------------------
+	// Check boundaries, skipping texts
+	// The entities are checked in parallel, the bullets that hit a wall lose their components at the next flush
+	registry.view<Motion>().exclude<Text>().parallel_each([&](Entity entity, Motion& motion) {
 		if ((motion.position.x - abs(motion.scale.x) / 2) < 0) {
 			if (registry.spikeballs.has(entity)) {
 				motion.velocity.x = motion.velocity.x * -1;
 				motion.position.x = abs(motion.scale.x) / 2;
 				registry.spikeballs.get(entity).prevC = -1;
-				continue;
+				return;
 			} 
 			 
 			motion.velocity.x = 0;
 			motion.position.x = abs(motion.scale.x) / 2;
 			
 			if (registry.shootBullets.has(entity) && !registry.eatables.has(entity)) {
-				registry.meshPtrs.remove(entity);
-				registry.hearts.remove(entity);
-				registry.renderRequests.remove(entity);
+				registry.commands().remove<Mesh*>(entity);
+				registry.commands().remove<Heart>(entity);
+				registry.commands().remove<RenderRequest>(entity);
 			}
 		}
 		if ((motion.position.x + abs(motion.scale.x) / 2) > window_width_px) {
@@ -933,16 +947,16 @@ void PhysicsSystem::step(float elapsed_ms)
 				motion.velocity.x = motion.velocity.x * -1;
 				motion.position.x = window_width_px - abs(motion.scale.x) / 2;
 				registry.spikeballs.get(entity).prevC = -1;
-				continue;
+				return;
 			}
 
 			motion.velocity.x = 0;
 			motion.position.x = window_width_px - abs(motion.scale.x) / 2;
 
 			if (registry.shootBullets.has(entity) && !registry.eatables.has(entity)) {
-				registry.meshPtrs.remove(entity);
-				registry.hearts.remove(entity);
-				registry.renderRequests.remove(entity);
+				registry.commands().remove<Mesh*>(entity);
+				registry.commands().remove<Heart>(entity);
+				registry.commands().remove<RenderRequest>(entity);
 			}
 		}
 		// don't really need to restrict top
@@ -950,18 +964,18 @@ void PhysicsSystem::step(float elapsed_ms)
 			motion.velocity.y *= -1;
 			motion.position.y = abs(motion.scale.y) / 2;
 			registry.spikeballs.get(entity).prevC = -1;
-			continue;
+			return;
 		}
 		if ((motion.position.y + abs(motion.scale.y) / 2) > window_height_px) {
 			if (registry.spikeballs.has(entity)) {
 				motion.velocity.y = motion.velocity.y * -1;
 				motion.position.y = window_height_px - abs(motion.scale.y) / 2;
 				registry.spikeballs.get(entity).prevC = -1;
-				continue;
+				return;
 			}
 			motion.velocity.y = 0;
 			motion.position.y = window_height_px - abs(motion.scale.y) / 2;
 		}
-	}
+	});
 }
 
@@ -4,14 +4,23 @@
 #include "tiny_ecs.hpp"
 #include "components.hpp"
 #include "tiny_ecs_registry.hpp"
+#include "platform_grid.hpp"
+#include "sweep_and_prune.hpp"
 
 // A simple physics system that moves rigid bodies and checks for collision
 class PhysicsSystem
 {
+	PlatformGrid platform_grid;
+	std::vector<unsigned int> nearby_platforms; // the result of the last platform_grid query, kept for its capacity
+	SweepAndPrune sweep_and_prune;
+	std::vector<SweepBounds> sweep_bounds; // by index in motions
+	std::vector<std::pair<unsigned int, unsigned int>> sweep_pairs;
+
 public:
 	void step(float elapsed_ms);
 
 	PhysicsSystem()
+		: platform_grid(registry.platforms, registry.motions, registry.on_restore)
 	{
 	}
 };
\ No newline at end of file
@@ -0,0 +1,124 @@
+// internal
+#include "platform_grid.hpp"
+
+// stlib
+#include <algorithm>
+#include <cmath>
+
+// Half the size of the bounding box, the scale is negative for flipped sprites
+static vec2 half_extent(const Platform& platform)
+{
+	return { std::abs(platform.scale.x) / 2.f, std::abs(platform.scale.y) / 2.f };
+}
+
+PlatformGrid::PlatformGrid(ComponentContainer<Platform>& platforms, ComponentContainer<Motion>& motions,
+	BasicSignal<>& on_restore, float cell_size)
+	: platforms(platforms)
+	, motions(motions)
+	, on_restore(on_restore)
+	, cell_size(cell_size)
+{
+	construct_listener = platforms.on_construct.connect([this](Entity) { dirty = true; });
+	destroy_listener = platforms.on_destroy.connect([this](Entity) { dirty = true; });
+	// A platform joining or leaving the group moves within platforms, other motions don't matter
+	motion_construct_listener = motions.on_construct.connect([this](Entity e) { dirty |= this->platforms.has(e); });
+	motion_destroy_listener = motions.on_destroy.connect([this](Entity e) { dirty |= this->platforms.has(e); });
+	restore_listener = on_restore.connect([this]() { dirty = true; });
+}
+
+PlatformGrid::~PlatformGrid()
+{
+	platforms.on_construct.disconnect(construct_listener);
+	platforms.on_destroy.disconnect(destroy_listener);
+	motions.on_construct.disconnect(motion_construct_listener);
+	motions.on_destroy.disconnect(motion_destroy_listener);
+	on_restore.disconnect(restore_listener);
+}
+
+void PlatformGrid::cell_range(float lo, float hi, float start, int count, int& first, int& last) const
+{
+	// Clamp as floats, positions far off the grid don't fit in an int
+	float lo_cell = std::floor((lo - start) / cell_size);
+	float hi_cell = std::floor((hi - start) / cell_size);
+	if (count == 0 || hi_cell < 0.f || lo_cell > float(count - 1))
+	{
+		first = 0;
+		last = -1;
+		return;
+	}
+	first = lo_cell < 0.f ? 0 : int(lo_cell);
+	last = hi_cell > float(count - 1) ? count - 1 : int(hi_cell);
+}
+
+void PlatformGrid::rebuild()
+{
+	dirty = false;
+	built_count = platforms.size();
+	cell_begin.clear();
+	cell_platforms.clear();
+	found.assign((platforms.size() + 63) / 64, 0);
+	columns = rows = 0;
+	if (platforms.size() == 0)
+		return;
+
+	vec2 lo = platforms.components[0].position;
+	vec2 hi = lo;
+	for (const Platform& platform : platforms.components)
+	{
+		vec2 half = half_extent(platform);
+		lo = { std::min(lo.x, platform.position.x - half.x), std::min(lo.y, platform.position.y - half.y) };
+		hi = { std::max(hi.x, platform.position.x + half.x), std::max(hi.y, platform.position.y + half.y) };
+	}
+	origin = lo;
+	columns = int((hi.x - lo.x) / cell_size) + 1;
+	rows = int((hi.y - lo.y) / cell_size) + 1;
+
+	// Counting sort into the cells, the platforms of a cell end up in increasing order
+	cell_begin.assign(size_t(columns) * rows + 1, 0);
+	auto for_each_cell = [&](const Platform& platform, auto fn) {
+		vec2 half = half_extent(platform);
+		int x0, x1, y0, y1;
+		cell_range(platform.position.x - half.x, platform.position.x + half.x, origin.x, columns, x0, x1);
+		cell_range(platform.position.y - half.y, platform.position.y + half.y, origin.y, rows, y0, y1);
+		for (int y = y0; y <= y1; y++)
+			for (int x = x0; x <= x1; x++)
+				fn(y * columns + x);
+	};
+	for (const Platform& platform : platforms.components)
+		for_each_cell(platform, [&](int cell) { cell_begin[cell + 1]++; });
+	for (size_t c = 1; c < cell_begin.size(); c++)
+		cell_begin[c] += cell_begin[c - 1];
+
+	cell_platforms.resize(cell_begin.back());
+	std::vector<unsigned int> next(cell_begin.begin(), cell_begin.end() - 1);
+	for (unsigned int p = 0; p < platforms.size(); p++)
+		for_each_cell(platforms.components[p], [&](int cell) { cell_platforms[next[cell]++] = p; });
+}
+
+void PlatformGrid::query(vec2 lo, vec2 hi, std::vector<unsigned int>& result)
+{
+	if (dirty)
+		rebuild();
+	assert(platforms.size() == built_count && "Platforms changed without a signal the grid listens to");
+	result.clear();
+
+	int x0, x1, y0, y1;
+	cell_range(lo.x, hi.x, origin.x, columns, x0, x1);
+	cell_range(lo.y, hi.y, origin.y, rows, y0, y1);
+	if (x0 > x1 || y0 > y1)
+		return;
+
+	// Platforms that span several cells show up once per cell, a bit per platform drops the duplicates and
+	// reading the bits back in order sorts them without comparing
+	std::fill(found.begin(), found.end(), 0);
+	for (int y = y0; y <= y1; y++)
+		for (int x = x0; x <= x1; x++)
+		{
+			int cell = y * columns + x;
+			for (unsigned int i = cell_begin[cell]; i < cell_begin[cell + 1]; i++)
+				found[cell_platforms[i] / 64] |= uint64_t(1) << (cell_platforms[i] % 64);
+		}
+	for (unsigned int word = 0; word < found.size(); word++)
+		for (uint64_t bits = found[word]; bits != 0; bits &= bits - 1)
+			result.push_back(word * 64 + lowest_bit(bits));
+}
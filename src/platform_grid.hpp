@@ -0,0 +1,55 @@
+#pragma once
+
+// stlib
+#include <vector>
+
+// internal
+#include "common.hpp"
+#include "tiny_ecs_registry.hpp" // not just components.hpp, Motion containers must see stable_addresses<Motion>
+
+// A uniform grid over the platforms of a level, so the physics step only looks at the platforms near an entity
+// Every cell lists the dense indices in platforms of the platforms whose bounding box overlaps it. Platforms
+// don't move, the grid is rebuilt on the first query after a platform was added or removed, or the registry
+// was restored from a snapshot. The Motion-Platform group also reorders the platforms when a platform gains
+// or loses its Motion, so the grid listens to the motions of platforms too.
+class PlatformGrid
+{
+	ComponentContainer<Platform>& platforms;
+	ComponentContainer<Motion>& motions;
+	BasicSignal<>& on_restore;
+	unsigned int construct_listener;
+	unsigned int destroy_listener;
+	unsigned int motion_construct_listener;
+	unsigned int motion_destroy_listener;
+	unsigned int restore_listener;
+	bool dirty = true;
+	size_t built_count = 0; // the number of platforms at the last rebuild, to catch changes the grid missed
+
+	float cell_size;
+	vec2 origin = { 0, 0 };
+	int columns = 0;
+	int rows = 0;
+	// The platforms of cell c are cell_platforms[cell_begin[c]] to cell_platforms[cell_begin[c + 1]]
+	std::vector<unsigned int> cell_begin;
+	std::vector<unsigned int> cell_platforms;
+	std::vector<uint64_t> found; // a bit per platform, the platforms a query has seen
+
+	void rebuild();
+	// The cell range covering [lo, hi] on one axis, clamped to the grid, empty if it misses the grid
+	void cell_range(float lo, float hi, float start, int count, int& first, int& last) const;
+
+public:
+	// motions and on_restore belong to the registry that holds platforms
+	PlatformGrid(ComponentContainer<Platform>& platforms, ComponentContainer<Motion>& motions, BasicSignal<>& on_restore,
+		float cell_size = 50.f);
+	PlatformGrid(const PlatformGrid&) = delete;
+	PlatformGrid& operator=(const PlatformGrid&) = delete;
+	~PlatformGrid();
+
+	void invalidate() { dirty = true; }
+
+	// Set result to the indices of the platforms in the cells that overlap the box [lo, hi], in increasing order
+	// The sort keeps the order of the old loop over all platforms, so collisions resolve the same way.
+	// Note, this is a superset of the platforms overlapping the box, callers still test the actual bounds.
+	void query(vec2 lo, vec2 hi, std::vector<unsigned int>& result);
+};
@@ -3,6 +3,7 @@
 #include <SDL.h>
 
 #include "tiny_ecs_registry.hpp"
+#include "alloc_tracker.hpp"
 #include <iostream>
 
 #include <glm/glm.hpp>
@@ -20,7 +21,7 @@ void RenderSystem::drawTexturedMesh(Entity entity,
 	// thus ORDER IS IMPORTANT
 	Transform transform;
 
-	transform.translate(motion.position);
+	transform.translate(interpolatedPosition(entity, motion.position));
 	transform.rotate(motion.angle);
 	transform.scale(motion.scale);
 
@@ -182,9 +183,9 @@ void RenderSystem::drawToScreen()
 	gl_has_errors();
 }
 
-void RenderSystem::renderDialog(Speech dialog) {
+void RenderSystem::renderDialog(const Speech& dialog) {
 
-	std::pair<Entity, std::string>& text= dialog.texts.front();
+	const std::pair<Entity, std::string>& text= dialog.texts.front();
 	Motion& motion = registry.motions.get(text.first);
 	float total_length = 0;
 
@@ -194,8 +195,9 @@ void RenderSystem::renderDialog(Speech dialog) {
 		total_length += (ch.Advance >> 6) * 0.4f + ch.Bearing.x * 0.4f;
 	}
 
-	float x = motion.position.x - total_length / 2;
-	float y = window_height_px - motion.position.y + 40;
+	vec2 position = interpolatedPosition(text.first, motion.position);
+	float x = position.x - total_length / 2;
+	float y = window_height_px - position.y + 40;
 
 	renderText(text.second, x, y, 0.4f, vec3(255, 255, 0), mat4(1.0f));
 }
@@ -273,8 +275,38 @@ void RenderSystem::renderText(const std::string& text, float x, float y,
 
 // Render our game world
 // http://www.opengl-tutorial.org/intermediate-tutorials/tutorial-14-render-to-texture/
-void RenderSystem::draw()
+void RenderSystem::storePreviousMotions()
 {
+	ComponentContainer<Motion>& motions = registry.motions;
+	for (unsigned int i = 0; i < motions.size(); i++)
+	{
+		Entity entity = motions.entities[i];
+		if (entity.index() >= previous_motions.size())
+			previous_motions.resize(entity.index() + 1);
+		previous_motions[entity.index()] = { entity, motions.components[i].position };
+	}
+}
+
+// Until the next step every entity is drawn where it is
+void RenderSystem::snapPreviousMotions()
+{
+	previous_motions.clear();
+}
+
+// Only the position is interpolated, angles and the sign of the scale, i.e. the facing, would sweep through
+// the values in between when they jump
+vec2 RenderSystem::interpolatedPosition(Entity entity, vec2 position) const
+{
+	if (entity.index() >= previous_motions.size() || previous_motions[entity.index()].entity != entity)
+		return position;
+	vec2 previous = previous_motions[entity.index()].position;
+	return previous + (position - previous) * interpolation;
+}
+
+void RenderSystem::draw(float alpha)
+{
+	AllocScope alloc_scope(ALLOC_SECTION::RENDER);
+	interpolation = alpha;
 	// Getting size of window
 	int w, h;
 	glfwGetFramebufferSize(window, &w, &h); // Note, this will be 2x the resolution given to glfwCreateWindow on retina displays
@@ -333,12 +365,13 @@ void RenderSystem::draw()
 	//glBindVertexArray(vao);
 	// Truely render to the screen
 	for (Entity entity : registry.texts.entities) {
-			Text text = registry.texts.get(entity);
-			std::string& content = text.text;
-			vec3& color = text.color;
+			const Text& text = registry.texts.get(entity);
+			const std::string& content = text.text;
+			const vec3& color = text.color;
 			glm::mat4 trans = glm::mat4(1.0f);
-			Motion motion = registry.motions.get(entity);
-			renderText(content, motion.position.x, motion.position.y, motion.scale.x, color, trans);
+			const Motion& motion = registry.motions.get(entity);
+			vec2 position = interpolatedPosition(entity, motion.position);
+			renderText(content, position.x, position.y, motion.scale.x, color, trans);
 
 	}
 	glGenVertexArrays(1, &vao);
@@ -126,7 +126,13 @@ public:
 	~RenderSystem();
 
 	// Draw all entities
-	void draw();
+	// Remember the positions before a simulation step, draw() interpolates from them to the current ones
+	void storePreviousMotions();
+	// Forget the previous positions, e.g. when a level is reloaded, so nothing slides from where it was before
+	void snapPreviousMotions();
+
+	// Draw the frame at alpha between the last two simulation steps, 0 is the previous and 1 the current one
+	void draw(float alpha = 1.f);
 
 	mat3 createProjectionMatrix();
 
@@ -134,9 +140,10 @@ public:
 private:
 	// Internal drawing functions for each entity type
 	void drawTexturedMesh(Entity entity, const mat3& projection);
+	vec2 interpolatedPosition(Entity entity, vec2 position) const;
 	void drawToScreen();
 	void renderText(const std::string& text, float x, float y, float scale, const glm::vec3& color, const glm::mat4& trans);
-	void renderDialog(Speech dialog);
+	void renderDialog(const Speech& dialog);
 	
 
 	// Window handle
@@ -148,6 +155,16 @@ private:
 	GLuint off_screen_render_buffer_depth;
 
 	Entity screen_state_entity;
+
+	// The position of each entity before the last simulation step, by entity index
+	// Entities that were created since don't have one and are drawn where they are.
+	struct PreviousMotion
+	{
+		unsigned int entity = 0;
+		vec2 position = { 0, 0 };
+	};
+	std::vector<PreviousMotion> previous_motions;
+	float interpolation = 1.f;
 };
 
 bool loadEffectFromFile(
@@ -0,0 +1,80 @@
+// internal
+#include "sweep_and_prune.hpp"
+
+// stlib
+#include <algorithm>
+
+// Left ends go before right ends of the same value, so boxes that touch count as overlapping
+static bool end_before(float value_a, unsigned int id_a, float value_b, unsigned int id_b)
+{
+	return value_a < value_b || (value_a == value_b && (id_a & 1) < (id_b & 1));
+}
+
+void SweepAndPrune::find_pairs(const std::vector<SweepBounds>& boxes, std::vector<std::pair<unsigned int, unsigned int>>& pairs)
+{
+	pairs.clear();
+	unsigned int count = (unsigned int)boxes.size();
+
+	// Drop the ends of the boxes that are gone or don't take part anymore and update the others in place
+	tracked.assign(count, 0);
+	size_t kept = 0;
+	for (End end : ends)
+	{
+		unsigned int box = end.id / 2;
+		if (box >= count || boxes[box].is_none())
+			continue;
+		end.value = (end.id & 1) ? boxes[box].right : boxes[box].left;
+		tracked[box] = 1;
+		ends[kept++] = end;
+	}
+	ends.resize(kept);
+
+	// New boxes are appended, a few of them are sorted in like the rest, a lot of them, e.g. after a level
+	// load, are faster to sort from scratch
+	size_t added = 0;
+	for (unsigned int box = 0; box < count; box++)
+		if (!tracked[box] && !boxes[box].is_none())
+		{
+			ends.push_back({ boxes[box].left, box * 2 });
+			ends.push_back({ boxes[box].right, box * 2 + 1 });
+			added += 2;
+		}
+	if (added > 32)
+	{
+		std::sort(ends.begin(), ends.end(), [](const End& a, const End& b) { return end_before(a.value, a.id, b.value, b.id); });
+	}
+	else
+	{
+		for (size_t i = 1; i < ends.size(); i++)
+		{
+			End end = ends[i];
+			size_t j = i;
+			for (; j > 0 && end_before(end.value, end.id, ends[j - 1].value, ends[j - 1].id); j--)
+				ends[j] = ends[j - 1];
+			ends[j] = end;
+		}
+	}
+
+	// Every box that is open when another one opens overlaps it on x, y is checked right away
+	open.clear();
+	for (const End& end : ends)
+	{
+		unsigned int box = end.id / 2;
+		if (end.id & 1)
+		{
+			auto it = std::find(open.begin(), open.end(), box);
+			*it = open.back();
+			open.pop_back();
+			continue;
+		}
+		const SweepBounds& bounds = boxes[box];
+		for (unsigned int other : open)
+		{
+			const SweepBounds& other_bounds = boxes[other];
+			if (other_bounds.top <= bounds.bot && bounds.top <= other_bounds.bot)
+				pairs.emplace_back(std::min(box, other), std::max(box, other));
+		}
+		open.push_back(box);
+	}
+	std::sort(pairs.begin(), pairs.end());
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+// stlib
+#include <utility>
+#include <vector>
+
+// The bounds of a box on both axes, see SweepAndPrune
+struct SweepBounds
+{
+	float left, right, top, bot;
+
+	// A box that doesn't take part in the sweep, e.g. a platform
+	static SweepBounds none() { return { 1.f, 0.f, 1.f, 0.f }; }
+	bool is_none() const { return left > right; }
+};
+
+// A broadphase that finds the boxes whose bounds overlap, by sweeping over their sorted ends on the x axis
+// The list of ends is kept between calls and only re-sorted, entities move little from frame to frame so
+// that is an insertion sort with few moves. The boxes are identified by their index, if an index stands for
+// another entity than last time its ends just move further in the sort.
+class SweepAndPrune
+{
+	// The left or right end of a box on the x axis
+	struct End
+	{
+		float value;
+		unsigned int id; // box * 2, + 1 for the right end
+	};
+
+	std::vector<End> ends;
+	std::vector<unsigned char> tracked; // whether a box has its ends in the list, by box
+	std::vector<unsigned int> open; // the boxes whose left end the sweep has passed but not the right one
+
+public:
+	// Set pairs to the pairs of boxes whose bounds overlap or touch, each as (lower index, higher index)
+	// The pairs are sorted, so callers see them in the order of a loop over all pairs.
+	void find_pairs(const std::vector<SweepBounds>& boxes, std::vector<std::pair<unsigned int, unsigned int>>& pairs);
+};
@@ -0,0 +1,74 @@
+// internal
+#include "tile_grid.hpp"
+
+// stlib
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+TileGrid level_tiles;
+
+void TileGrid::assign(const std::vector<std::vector<char>>& map, const char* solid, float cell_size, vec2 tile_extent)
+{
+	this->cell_size = cell_size;
+	this->tile_extent = tile_extent;
+	rows = (int)map.size();
+	columns = 0;
+	for (const std::vector<char>& line : map)
+		columns = std::max(columns, (int)line.size());
+	row_words = (columns + 63) / 64;
+	bits.assign(size_t(rows) * row_words, 0);
+
+	for (int row = 0; row < rows; row++)
+		for (int column = 0; column < (int)map[row].size(); column++)
+			if (map[row][column] != '\0' && strchr(solid, map[row][column]))
+				bits[size_t(row) * row_words + column / 64] |= uint64_t(1) << (column % 64);
+}
+
+void TileGrid::clear()
+{
+	rows = columns = row_words = 0;
+	bits.clear();
+}
+
+void TileGrid::cell_range(float lo, float hi, float extent, int count, int& first, int& last) const
+{
+	// Clamped as floats, positions far off the grid don't fit in an int
+	float first_cell = std::ceil((lo - extent / 2) / cell_size);
+	float last_cell = std::floor((hi + extent / 2) / cell_size);
+	if (last_cell < 0.f || first_cell > float(count - 1))
+	{
+		first = 0;
+		last = -1;
+		return;
+	}
+	first = first_cell < 0.f ? 0 : int(first_cell);
+	last = last_cell > float(count - 1) ? count - 1 : int(last_cell);
+}
+
+bool TileGrid::overlaps(vec2 lo, vec2 hi) const
+{
+	int first_column, last_column, first_row, last_row;
+	cell_range(lo.x, hi.x, tile_extent.x, columns, first_column, last_column);
+	cell_range(lo.y, hi.y, tile_extent.y, rows, first_row, last_row);
+	if (first_column > last_column || first_row > last_row)
+		return false;
+
+	// The columns as a mask per word, tested against each covered row
+	int first_word = first_column / 64, last_word = last_column / 64;
+	for (int row = first_row; row <= last_row; row++)
+	{
+		const uint64_t* words = &bits[size_t(row) * row_words];
+		for (int word = first_word; word <= last_word; word++)
+		{
+			uint64_t mask = ~uint64_t(0);
+			if (word == first_word)
+				mask &= ~uint64_t(0) << (first_column % 64);
+			if (word == last_word)
+				mask &= ~uint64_t(0) >> (63 - last_column % 64);
+			if (words[word] & mask)
+				return true;
+		}
+	}
+	return false;
+}
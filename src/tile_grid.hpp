@@ -0,0 +1,42 @@
+#pragma once
+
+// stlib
+#include <stdint.h>
+#include <vector>
+
+// internal
+#include "common.hpp"
+
+// The solid tiles of a level map, a bit per map cell in rows of 64-bit words
+// Answers whether a box touches the level at all without looking at the platform entities, a query costs the
+// number of cells the box covers, however large the map is. A tile at row r and column c collides as the box
+// of size tile_extent around (c, r) * cell_size, like the platform tiles of a map.
+class TileGrid
+{
+	int rows = 0;
+	int columns = 0;
+	int row_words = 0; // the words per row
+	std::vector<uint64_t> bits;
+	float cell_size = 1.f;
+	vec2 tile_extent = { 0, 0 };
+
+	// The cells whose tile box can overlap [lo, hi] on one axis, clamped to the grid, empty if it misses the grid
+	void cell_range(float lo, float hi, float extent, int count, int& first, int& last) const;
+
+public:
+	// Mark the cells of the map that hold one of the characters in 'solid', e.g. the output of loadMap
+	void assign(const std::vector<std::vector<char>>& map, const char* solid, float cell_size, vec2 tile_extent);
+	void clear();
+
+	bool is_solid(int row, int column) const
+	{
+		return row >= 0 && row < rows && column >= 0 && column < columns &&
+			(bits[size_t(row) * row_words + column / 64] >> (column % 64)) & 1;
+	}
+
+	// Whether the box [lo, hi] overlaps the box of a solid tile, touching boxes count
+	bool overlaps(vec2 lo, vec2 hi) const;
+};
+
+// The tiles of the current level, assigned when its map is loaded
+extern TileGrid level_tiles;
@@ -2,4 +2,8 @@
 #include "tiny_ecs.hpp"
 
 // All we need to store besides the containers is the id of every entity and callbacks to be able to remove entities across containers
-unsigned int Entity::id_count = 1;
\ No newline at end of file
+unsigned int Entity::id_count = 1;
+std::vector<unsigned int> Entity::generations;
+std::vector<unsigned int> Entity::free_indices;
+unsigned char Entity::current_scope = Entity::global_scope;
+std::vector<unsigned char> Entity::scopes;
\ No newline at end of file
@@ -2,50 +2,696 @@
 
 #include <algorithm>
 #include <vector>
+#include <memory>
+#include <array>
+#include <atomic>
+#include <tuple>
+#include <utility>
 #include <unordered_map>
 #include <set>
 #include <functional>
+#include <mutex>
+#include <numeric>
 #include <typeindex>
+#include <typeinfo>
+#include <type_traits>
+#include <cstdio>
+#include <cstring>
+#include <string>
 #include <assert.h>
+#include <stdint.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "worker_pool.hpp"
+
+// A contiguous buffer that captures the registry, see ComponentRegistry::snapshot
+// Values are appended by write and read back in the same order by read. Arrays of trivially copyable
+// types are aligned in the buffer, so they are copied as a whole on both ways.
+class Snapshot
+{
+	std::vector<unsigned char> data;
+	size_t position = 0; // the read position
+
+	void align(size_t alignment)
+	{
+		data.resize((data.size() + alignment - 1) / alignment * alignment);
+	}
+
+public:
+	// Empty the buffer, its memory is kept for the next capture
+	void clear()
+	{
+		data.clear();
+		position = 0;
+	}
+	// Start reading from the beginning again
+	void rewind()
+	{
+		position = 0;
+	}
+	size_t size() const
+	{
+		return data.size();
+	}
+
+	void write(const void* src, size_t bytes)
+	{
+		size_t offset = data.size();
+		data.resize(offset + bytes);
+		if (bytes > 0)
+			memcpy(data.data() + offset, src, bytes);
+	}
+	void read(void* dst, size_t bytes)
+	{
+		assert(position + bytes <= data.size() && "Read past the end of the snapshot");
+		if (bytes > 0)
+			memcpy(dst, data.data() + position, bytes);
+		position += bytes;
+	}
+
+	template <typename T>
+	void write_value(const T& value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be copied into a snapshot");
+		write(&value, sizeof(T));
+	}
+	template <typename T>
+	T read_value()
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be copied into a snapshot");
+		// Read into raw memory, constructing a T may have side effects, e.g. for an Entity
+		alignas(T) unsigned char value[sizeof(T)];
+		read(value, sizeof(T));
+		return *reinterpret_cast<T*>(value);
+	}
+
+	// A size followed by the elements as one block
+	template <typename T>
+	void write_array(const std::vector<T>& values)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be copied into a snapshot");
+		write_value((uint32_t)values.size());
+		align(alignof(T));
+		write(values.data(), values.size() * sizeof(T));
+	}
+	// Replaces the content of values, T doesn't need a default constructor
+	template <typename T>
+	void read_array(std::vector<T>& values)
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be copied into a snapshot");
+		uint32_t count = read_value<uint32_t>();
+		position = (position + alignof(T) - 1) / alignof(T) * alignof(T);
+		assert(position + count * sizeof(T) <= data.size() && "Read past the end of the snapshot");
+		const T* first = reinterpret_cast<const T*>(data.data() + position);
+		values.assign(first, first + count);
+		position += count * sizeof(T);
+	}
+
+	void write_string(const std::string& text)
+	{
+		write_value((uint32_t)text.size());
+		write(text.data(), text.size());
+	}
+	std::string read_string()
+	{
+		uint32_t length = read_value<uint32_t>();
+		assert(position + length <= data.size() && "Read past the end of the snapshot");
+		std::string text((const char*)data.data() + position, length);
+		position += length;
+		return text;
+	}
+};
 
 // Unique identifyer for all entities
+// The id packs an index (low bits) and a generation (high bits). The index of a destroyed entity is
+// re-used by a later entity with a bumped generation, so stale handles can be told apart from live ones.
 class Entity
 {
 	unsigned int id;
 	static unsigned int id_count; // starts from 1, entit 0 is the default initialization
+	static std::vector<unsigned int> generations; // the current generation of every index
+	static std::vector<unsigned int> free_indices; // indices of released entities, ready for re-use
+	static unsigned char current_scope; // the scope new entities belong to
+	static std::vector<unsigned char> scopes; // the scope of every index, no_scope if it is free
+
+	Entity(unsigned int index, unsigned int generation) : id((generation << index_bits) | index) {}
 public:
+	static constexpr unsigned int index_bits = 20;
+	static constexpr unsigned int index_mask = (1u << index_bits) - 1;
+	static constexpr unsigned int generation_mask = (1u << (32 - index_bits)) - 1;
+
+	// Entities belong to the scope that was current when they were created, e.g. a level, and a scope can
+	// be torn down as a whole, see ComponentRegistry::destroy_scope. Entities live in the global scope unless
+	// another one was entered.
+	static constexpr unsigned char global_scope = 0;
+	static constexpr unsigned char no_scope = 0xff;
+
 	Entity()
 	{
-		id = id_count++;
-		// Note, indices of already deleted entities arent re-used in this simple implementation.
+		unsigned int index;
+		if (!free_indices.empty())
+		{
+			index = free_indices.back();
+			free_indices.pop_back();
+		}
+		else
+		{
+			index = id_count++;
+			assert(index <= index_mask && "Ran out of entity indices");
+			generations.resize(index + 1, 0);
+			scopes.resize(index + 1, no_scope);
+		}
+		id = (generations[index] << index_bits) | index;
+		scopes[index] = current_scope;
+	}
+	operator unsigned int() const { return id; } // this enables automatic casting to int
+
+	unsigned int index() const { return id & index_mask; }
+	unsigned int generation() const { return id >> index_bits; }
+
+	// The live entity that currently has the given index, without creating a new one
+	static Entity from_index(unsigned int index)
+	{
+		assert(index > 0 && index < generations.size());
+		Entity e(index, generations[index]);
+		return e;
+	}
+
+	// Check that the entity hasn't been released, i.e. the handle is not stale
+	static bool is_alive(Entity e)
+	{
+		unsigned int index = e.index();
+		return index > 0 && index < generations.size() && generations[index] == e.generation();
+	}
+
+	// Release the index of an entity for re-use, all existing handles to it become stale
+	static void release(Entity e)
+	{
+		if (!is_alive(e))
+			return;
+		unsigned int index = e.index();
+		generations[index] = (generations[index] + 1) & generation_mask;
+		scopes[index] = no_scope;
+		free_indices.push_back(index);
+	}
+
+	// Entities created from now on belong to the given scope
+	static void enter_scope(unsigned char scope)
+	{
+		assert(scope != no_scope);
+		current_scope = scope;
+	}
+	static unsigned char scope_of(Entity e)
+	{
+		return is_alive(e) ? scopes[e.index()] : no_scope;
+	}
+
+	// Release all entities of a scope in a single pass over the indices
+	// Note, their components are not removed, see ComponentRegistry::destroy_scope.
+	static void release_scope(unsigned char scope)
+	{
+		assert(scope != no_scope);
+		for (unsigned int index = 1; index < scopes.size(); index++)
+		{
+			if (scopes[index] != scope)
+				continue;
+			generations[index] = (generations[index] + 1) & generation_mask;
+			scopes[index] = no_scope;
+			free_indices.push_back(index);
+		}
+	}
+
+	// Make room for count more entities, e.g. before creating the tiles of a level
+	static void reserve(size_t count)
+	{
+		generations.reserve(generations.size() + count);
+		scopes.reserve(scopes.size() + count);
+	}
+
+	// Capture and restore the allocator, i.e. which indices are in use and their generations
+	static void snapshot(Snapshot& snapshot)
+	{
+		snapshot.write_value(id_count);
+		snapshot.write_array(generations);
+		snapshot.write_array(free_indices);
+		snapshot.write_value(current_scope);
+		snapshot.write_array(scopes);
+	}
+	static void restore(Snapshot& snapshot)
+	{
+		id_count = snapshot.read_value<unsigned int>();
+		snapshot.read_array(generations);
+		snapshot.read_array(free_indices);
+		current_scope = snapshot.read_value<unsigned char>();
+		snapshot.read_array(scopes);
+	}
+};
+
+// Index of the lowest set bit, bits must not be 0
+inline unsigned int lowest_bit(uint64_t bits)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward64(&index, bits);
+	return (unsigned int)index;
+#else
+	return (unsigned int)__builtin_ctzll(bits);
+#endif
+}
+
+// Index of the highest set bit, bits must not be 0
+inline unsigned int highest_bit(uint64_t bits)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanReverse64(&index, bits);
+	return (unsigned int)index;
+#else
+	return 63u - (unsigned int)__builtin_clzll(bits);
+#endif
+}
+
+// Number of set bits
+inline unsigned int bit_count(uint64_t bits)
+{
+#ifdef _MSC_VER
+	return (unsigned int)__popcnt64(bits);
+#else
+	return (unsigned int)__builtin_popcountll(bits);
+#endif
+}
+
+// The signature of an entity has one bit per component type it owns, indexed by the entity index
+class SignatureTable
+{
+	std::vector<uint64_t> signatures;
+public:
+	static constexpr unsigned int max_types = 64;
+
+	uint64_t get(Entity e) const
+	{
+		unsigned int index = e.index();
+		if (index >= signatures.size() || !Entity::is_alive(e))
+			return 0;
+		return signatures[index];
+	}
+	// Signature of an entity that is known to be alive, e.g. because a container holds it
+	uint64_t get_alive(Entity e) const
+	{
+		return signatures[e.index()];
+	}
+	void set(Entity e, unsigned int bit)
+	{
+		unsigned int index = e.index();
+		if (index >= signatures.size())
+			signatures.resize(index + 1, 0);
+		signatures[index] |= uint64_t(1) << bit;
+	}
+	void reset(Entity e, unsigned int bit)
+	{
+		unsigned int index = e.index();
+		if (index < signatures.size())
+			signatures[index] &= ~(uint64_t(1) << bit);
+	}
+
+	void snapshot(Snapshot& snapshot) const
+	{
+		snapshot.write_array(signatures);
+	}
+	void restore(Snapshot& snapshot)
+	{
+		snapshot.read_array(signatures);
+	}
+
+	size_t bytes() const
+	{
+		return signatures.capacity() * sizeof(uint64_t);
 	}
-	operator unsigned int() { return id; } // this enables automatic casting to int
 };
 
-// Common interface to refer to all containers in the ECS registry
-struct ContainerInterface
+// Interface of the owning groups a container takes part in, see OwningGroup
+struct GroupInterface
 {
-	virtual void clear() = 0;
 	virtual size_t size() = 0;
-	virtual void remove(Entity e) = 0;
-	virtual bool has(Entity entity) = 0;
+	// Recount the members after the containers were restored from a snapshot
+	virtual void restore() = 0;
+};
+
+// A list of listeners that are called with the arguments of emit(), see Signal
+template <typename... Args>
+class BasicSignal
+{
+	std::vector<std::pair<unsigned int, std::function<void(Args...)>>> listeners;
+	unsigned int next_id = 0;
+public:
+	// Add a listener, returns the id to disconnect it again
+	unsigned int connect(std::function<void(Args...)> listener)
+	{
+		listeners.emplace_back(next_id, std::move(listener));
+		return next_id++;
+	}
+	void disconnect(unsigned int id)
+	{
+		for (size_t i = 0; i < listeners.size(); i++)
+			if (listeners[i].first == id)
+			{
+				listeners.erase(listeners.begin() + i);
+				return;
+			}
+	}
+	bool empty() const
+	{
+		return listeners.empty();
+	}
+	void emit(Args... args)
+	{
+		for (size_t i = 0; i < listeners.size(); i++)
+			listeners[i].second(args...);
+	}
+};
+
+// Listeners that are called with an entity, see ComponentContainer::on_construct
+using Signal = BasicSignal<Entity>;
+
+// Opt-in per component type: components that are referenced across inserts, e.g. a Motion& kept while
+// creating further entities, are stored in a PagedPool so the reference stays valid. Specialize as
+// template <> struct stable_addresses<Motion> : std::true_type {};
+template <typename Component>
+struct stable_addresses : std::false_type {};
+
+// Memory and access statistics of a container, see ComponentRegistry::stats
+struct ContainerStats
+{
+	const char* name = "";
+	size_t size = 0; // components in the container
+	size_t capacity = 0; // components that fit before the container grows
+	size_t bytes = 0; // memory held by the container, including the sparse pages
+	size_t sparse_pages = 0; // allocated pages of the sparse array
+	float sparse_occupancy = 0.f; // share of the allocated sparse slots in use, what the load factor was for the hash map
+	// Calls since the last reset_counters(), only counted with ECS_INSTRUMENTATION
+	uint64_t has = 0;
+	uint64_t get = 0;
+	uint64_t insert = 0;
+	uint64_t remove = 0;
+};
+
+// The statistics of all containers of a registry
+struct RegistryStats
+{
+	std::vector<ContainerStats> containers; // in type id order
+	size_t bytes = 0; // of all containers and the signature table
+};
+
+// Counts the has/get/insert/remove calls of a container, compiled in with ECS_INSTRUMENTATION
+// The counters are atomic, systems may read the registry from several threads.
+class AccessCounters
+{
+public:
+	enum Call { HAS, GET, INSERT, REMOVE, CALL_COUNT };
+#ifdef ECS_INSTRUMENTATION
+	void count(Call call) { calls[call].fetch_add(1, std::memory_order_relaxed); }
+	uint64_t get(Call call) const { return calls[call].load(std::memory_order_relaxed); }
+	void reset()
+	{
+		for (std::atomic<uint64_t>& calls_of : calls)
+			calls_of.store(0, std::memory_order_relaxed);
+	}
+private:
+	std::array<std::atomic<uint64_t>, CALL_COUNT> calls{};
+#else
+	void count(Call) {}
+	uint64_t get(Call) const { return 0; }
+	void reset() {}
+#endif
+};
+
+// A sequence of components whose addresses never change
+// The components live in fixed-size pages and the sequence is an array of pointers into them, so reordering
+// the sequence only moves pointers and growing it adds a page instead of copying the components.
+// Every page keeps a free list of its slots, freed slots are re-used before a new page is allocated.
+template <typename T>
+class PagedPool
+{
+	static constexpr unsigned int page_bits = 8;
+	static constexpr unsigned int page_size = 1u << page_bits;
+
+	struct Page
+	{
+		alignas(T) unsigned char storage[page_size * sizeof(T)];
+		unsigned int free_slots[page_size];
+		unsigned int free_count = 0;
+	};
+	std::vector<std::unique_ptr<Page>> pages;
+	std::vector<unsigned int> pages_with_free; // pages that have at least one free slot
+
+	// The sequence, and the page and slot of every element as page << page_bits | slot
+	std::vector<T*> items;
+	std::vector<unsigned int> item_slots;
+
+	void add_page()
+	{
+		Page* page = new Page();
+		for (unsigned int i = 0; i < page_size; i++)
+			page->free_slots[i] = page_size - 1 - i; // low slots first
+		page->free_count = page_size;
+		pages_with_free.push_back((unsigned int)pages.size());
+		pages.emplace_back(page);
+	}
+
+	unsigned int allocate()
+	{
+		if (pages_with_free.empty())
+			add_page();
+		unsigned int index = pages_with_free.back();
+		Page& page = *pages[index];
+		unsigned int slot = page.free_slots[--page.free_count];
+		if (page.free_count == 0)
+			pages_with_free.pop_back();
+		return (index << page_bits) | slot;
+	}
+
+	void release(unsigned int id)
+	{
+		Page& page = *pages[id >> page_bits];
+		if (page.free_count == 0)
+			pages_with_free.push_back(id >> page_bits);
+		page.free_slots[page.free_count++] = id & (page_size - 1);
+	}
+
+public:
+	// Iterates the sequence like a vector iterator
+	class Iterator
+	{
+		T* const* item;
+	public:
+		Iterator(T* const* item) : item(item) {}
+		T& operator*() const { return **item; }
+		T* operator->() const { return *item; }
+		Iterator& operator++() { item++; return *this; }
+		bool operator==(const Iterator& other) const { return item == other.item; }
+		bool operator!=(const Iterator& other) const { return item != other.item; }
+	};
+
+	PagedPool() {}
+	PagedPool(const PagedPool&) = delete;
+	PagedPool& operator=(const PagedPool&) = delete;
+	~PagedPool()
+	{
+		clear();
+	}
+
+	size_t size() const { return items.size(); }
+	bool empty() const { return items.empty(); }
+	T& operator[](size_t i) { return *items[i]; }
+	const T& operator[](size_t i) const { return *items[i]; }
+	T& back() { return *items.back(); }
+	Iterator begin() const { return Iterator(items.data()); }
+	Iterator end() const { return Iterator(items.data() + items.size()); }
+
+	// The number of components that fit into the allocated pages, and the memory held by the pool
+	size_t capacity() const { return pages.size() * page_size; }
+	size_t bytes() const
+	{
+		return pages.size() * sizeof(Page) + pages.capacity() * sizeof(pages[0])
+			+ pages_with_free.capacity() * sizeof(unsigned int)
+			+ items.capacity() * sizeof(T*) + item_slots.capacity() * sizeof(unsigned int);
+	}
+
+	// Make room for count components, allocating the pages up front
+	void reserve(size_t count)
+	{
+		items.reserve(count);
+		item_slots.reserve(count);
+		while (pages.size() * page_size < count)
+			add_page();
+	}
+
+	void push_back(T&& value)
+	{
+		unsigned int id = allocate();
+		T* item = new (pages[id >> page_bits]->storage + (id & (page_size - 1)) * sizeof(T)) T(std::move(value));
+		items.push_back(item);
+		item_slots.push_back(id);
+	}
+
+	void pop_back()
+	{
+		items.back()->~T();
+		release(item_slots.back());
+		items.pop_back();
+		item_slots.pop_back();
+	}
+
+	// Swap two positions of the sequence, the components stay where they are
+	void swap_items(size_t a, size_t b)
+	{
+		std::swap(items[a], items[b]);
+		std::swap(item_slots[a], item_slots[b]);
+	}
+
+	// Destroy all components, the pages are kept for re-use
+	void clear()
+	{
+		while (!items.empty())
+			pop_back();
+	}
 };
 
 // A container that stores components of type 'Component' and associated entities
+// Implemented as a sparse set: a paged sparse array maps an entity id to its position in the
+// densely packed components and entities arrays, so has() and get() are a couple of array reads.
 template <typename Component> // A component can be any class
-class ComponentContainer : public ContainerInterface
+class ComponentContainer
 {
 private:
-	// The hash map from Entity -> array index.
-	std::unordered_map<unsigned int, unsigned int> map_entity_componentID; // the entity is cast to uint to be hashable.
+	// Marks the entities in 'updated' by entity index
+	std::vector<bool> updated_flags;
+
+	// The sparse array from Entity -> array index, split into pages that are allocated on first use
+	static constexpr unsigned int page_bits = 10;
+	static constexpr unsigned int page_size = 1u << page_bits;
+	static constexpr unsigned int npos = ~0u; // marks an entity that has no component in this container
+	std::vector<std::unique_ptr<unsigned int[]>> sparse_pages;
 	bool registered = false;
+
+	AccessCounters counters;
+
+	// Returns the dense index of an entity, or npos if it isn't contained
+	// The slot is found by index, a stale handle is rejected by comparing against the stored entity
+	unsigned int dense_index(Entity e) const
+	{
+		unsigned int id = e.index();
+		unsigned int page = id >> page_bits;
+		if (page >= sparse_pages.size() || !sparse_pages[page])
+			return npos;
+		unsigned int i = sparse_pages[page][id & (page_size - 1)];
+		if (i == npos || entities[i] != e)
+			return npos;
+		return i;
+	}
+
+	// Exchange the components at two positions, a stable pool only exchanges the pointers
+	void swap_components(unsigned int a, unsigned int b)
+	{
+		if constexpr (stable)
+			components.swap_items(a, b);
+		else
+			std::swap(components[a], components[b]);
+	}
+
+	// The dense positions in sorted order, order[i] is the old position of what goes to i, see sort()
+	std::vector<unsigned int> order;
+
+	void reset_order()
+	{
+		order.resize(entities.size());
+		for (unsigned int i = 0; i < order.size(); i++)
+			order[i] = i;
+	}
+
+	// Move the entities and components to their sorted positions, a cycle of the permutation at a time
+	void apply_order()
+	{
+		for (unsigned int start = 0; start < order.size(); start++)
+		{
+			unsigned int curr = start;
+			while (order[curr] != start)
+			{
+				unsigned int next = order[curr];
+				swap_components(curr, next);
+				std::swap(entities[curr], entities[next]);
+				order[curr] = curr;
+				curr = next;
+			}
+			order[curr] = curr;
+		}
+		for (unsigned int i = 0; i < entities.size(); i++)
+			sparse_slot(entities[i]) = i;
+	}
+
+	// A single component in a snapshot, see snapshot()
+	static void save_component(Snapshot& snapshot, const Component& c)
+	{
+		if constexpr (std::is_trivially_copyable<Component>::value)
+			snapshot.write_value(c);
+		else
+			save(snapshot, c);
+	}
+	static Component load_component(Snapshot& snapshot)
+	{
+		if constexpr (std::is_trivially_copyable<Component>::value)
+			return snapshot.read_value<Component>();
+		else
+		{
+			Component c;
+			load(snapshot, c);
+			return c;
+		}
+	}
+
+	// Returns the sparse slot of an entity index, allocating its page if needed
+	unsigned int& sparse_slot(Entity e)
+	{
+		unsigned int id = e.index();
+		unsigned int page = id >> page_bits;
+		if (page >= sparse_pages.size())
+			sparse_pages.resize(page + 1);
+		if (!sparse_pages[page])
+		{
+			sparse_pages[page].reset(new unsigned int[page_size]);
+			std::fill(sparse_pages[page].get(), sparse_pages[page].get() + page_size, npos);
+		}
+		return sparse_pages[page][id & (page_size - 1)];
+	}
+
 public:
+	// Whether the components are kept at stable addresses, see stable_addresses
+	static constexpr bool stable = stable_addresses<Component>::value;
+
 	// Container of all components of type 'Component'
-	std::vector<Component> components;
+	typename std::conditional<stable, PagedPool<Component>, std::vector<Component>>::type components;
 
 	// The corresponding entities
 	std::vector<Entity> entities;
 
+	// The owning groups that arrange this container, see OwningGroup
+	std::vector<GroupInterface*> groups;
+
+	// Called after a component was inserted, after it was changed through patch(), and before it is removed
+	Signal on_construct;
+	Signal on_update;
+	Signal on_destroy;
+
+	// The entities whose component was changed through patch() since the last clear_updated()
+	// Note, an entity may have lost the component since, check has() before using it.
+	std::vector<Entity> updated;
+
+	// The signature table this container keeps up to date and the bit of its component type
+	SignatureTable* signatures = nullptr;
+	unsigned int signature_bit = 0;
+
 	// Constructor that registers the type
 	ComponentContainer()
 	{
@@ -55,12 +701,19 @@ public:
 	inline Component& insert(Entity e, Component c, bool check_for_duplicates = true)
 	{
 		// Usually, every entity should only have one instance of each component type
-		assert(!(check_for_duplicates && has(e)) && "Entity already contained in ECS registry");
+		assert(!(check_for_duplicates && dense_index(e) != npos) && "Entity already contained in ECS registry");
+		assert(Entity::is_alive(e) && "Entity was already destroyed");
+		counters.count(AccessCounters::INSERT);
 
-		map_entity_componentID[e] = (unsigned int)components.size();
+		sparse_slot(e) = (unsigned int)components.size();
 		components.push_back(std::move(c)); // the move enforces move instead of copy constructor
 		entities.push_back(e);
-		return components.back();
+		if (signatures)
+			signatures->set(e, signature_bit);
+		if (on_construct.empty())
+			return components.back();
+		on_construct.emit(e);
+		return components[sparse_slot(e)]; // the listeners may have moved the new component, e.g. a group
 	};
 
 	// The emplace function takes the the provided arguments Args, creates a new object of type Component, and inserts it into the ECS system
@@ -75,63 +728,1226 @@ public:
 
 	// A wrapper to return the component of an entity
 	Component& get(Entity e) {
-		assert(has(e) && "Entity not contained in ECS registry");
-		return components[map_entity_componentID[e]];
+		counters.count(AccessCounters::GET);
+		unsigned int i = dense_index(e);
+		assert(i != npos && "Entity not contained in ECS registry");
+		return components[i];
+	}
+
+	// Returns the component of an entity, or nullptr if it doesn't have one
+	Component* try_get(Entity e) {
+		counters.count(AccessCounters::GET);
+		unsigned int i = dense_index(e);
+		return i == npos ? nullptr : &components[i];
+	}
+
+	// Change the component of an entity through fn(Component&), which marks it as updated
+	template <typename Function>
+	Component& patch(Entity e, Function fn)
+	{
+		Component& c = get(e);
+		fn(c);
+		unsigned int index = e.index();
+		if (index >= updated_flags.size())
+			updated_flags.resize(index + 1, false);
+		if (!updated_flags[index])
+		{
+			updated_flags[index] = true;
+			updated.push_back(e);
+		}
+		on_update.emit(e);
+		return c;
+	}
+
+	// Start a new round of change tracking, usually once per frame
+	void clear_updated()
+	{
+		for (Entity e : updated)
+			updated_flags[e.index()] = false;
+		updated.clear();
 	}
 
 	// Check if entity has a component of type 'Component'
 	bool has(Entity entity) {
-		return map_entity_componentID.count(entity) > 0;
+		counters.count(AccessCounters::HAS);
+		return dense_index(entity) != npos;
 	}
 
 	// Remove an component and pack the container to re-use the empty space
 	void remove(Entity e)
 	{
-		if (has(e))
+		counters.count(AccessCounters::REMOVE);
+		if (!on_destroy.empty() && dense_index(e) != npos)
+			on_destroy.emit(e);
+		unsigned int cID = dense_index(e);
+		if (cID != npos)
 		{
-			// Get the current position
-			int cID = map_entity_componentID[e];
-
 			// Move the last element to position cID using the move operator
 			// Note, components[cID] = components.back() would trigger the copy instead of move operator
-			components[cID] = std::move(components.back());
+			if constexpr (stable)
+				components.swap_items(cID, components.size() - 1);
+			else
+				components[cID] = std::move(components.back());
 			entities[cID] = entities.back(); // the entity is only a single index, copy it.
-			map_entity_componentID[entities.back()] = cID;
+			sparse_slot(entities.back()) = cID;
 
 			// Erase the old component and free its memory
-			map_entity_componentID.erase(e);
+			sparse_slot(e) = npos;
+			if (signatures)
+				signatures->reset(e, signature_bit);
 			components.pop_back();
 			entities.pop_back();
-			// Note, one could mark the id for re-use
 		}
 	};
 
 	// Remove all components of type 'Component'
 	void clear()
 	{
-		map_entity_componentID.clear();
+		// Take entities out one by one so that every listener sees them go
+		if (!on_destroy.empty())
+		{
+			while (!entities.empty())
+				remove(entities.back());
+			return;
+		}
+		// Only reset the slots in use, the sparse pages are kept for re-use
+		for (Entity e : entities)
+		{
+			sparse_slot(e) = npos;
+			if (signatures)
+				signatures->reset(e, signature_bit);
+		}
 		components.clear();
 		entities.clear();
 	}
 
+	// Remove the components of all entities that satisfy pred(Entity) in a single pass
+	// The remaining components keep their order, so the owning groups only need to be recounted. No signals
+	// are emitted, the removed entities are added to 'removed' if there are on_destroy listeners to tell.
+	template <typename Predicate>
+	void remove_if(Predicate pred, std::vector<Entity>& removed)
+	{
+		unsigned int kept = 0;
+		for (unsigned int i = 0; i < entities.size(); i++)
+		{
+			Entity e = entities[i];
+			if (pred(e))
+			{
+				sparse_slot(e) = npos;
+				if (signatures)
+					signatures->reset(e, signature_bit);
+				if (!on_destroy.empty())
+					removed.push_back(e);
+				continue;
+			}
+			if (kept != i)
+			{
+				if constexpr (stable)
+					components.swap_items(kept, i);
+				else
+					components[kept] = std::move(components[i]);
+				entities[kept] = e;
+				sparse_slot(e) = kept;
+			}
+			kept++;
+		}
+		if constexpr (stable)
+			while (components.size() > kept)
+				components.pop_back();
+		else
+			components.erase(components.begin() + kept, components.end());
+		entities.resize(kept);
+	}
+
 	// Report the number of components of type 'Component'
 	size_t size()
 	{
 		return components.size();
 	}
 
+	// Make room for count components, so that inserting them doesn't grow the arrays on the way
+	void reserve(size_t count)
+	{
+		components.reserve(count);
+		entities.reserve(count);
+	}
+
+	// Memory and occupancy, and the calls counted since the last reset_counters()
+	// Note, memory the components allocate themselves, e.g. for strings, is not included.
+	ContainerStats stats() const
+	{
+		ContainerStats stats;
+		stats.name = typeid(Component).name();
+		stats.size = components.size();
+		stats.capacity = components.capacity();
+		if constexpr (stable)
+			stats.bytes = components.bytes();
+		else
+			stats.bytes = components.capacity() * sizeof(Component);
+		stats.bytes += entities.capacity() * sizeof(Entity) + updated.capacity() * sizeof(Entity) + updated_flags.capacity() / 8;
+		for (const std::unique_ptr<unsigned int[]>& page : sparse_pages)
+			stats.sparse_pages += page ? 1 : 0;
+		stats.bytes += sparse_pages.capacity() * sizeof(sparse_pages[0]) + stats.sparse_pages * page_size * sizeof(unsigned int);
+		if (stats.sparse_pages > 0)
+			stats.sparse_occupancy = (float)stats.size / (float)(stats.sparse_pages * page_size);
+		stats.has = counters.get(AccessCounters::HAS);
+		stats.get = counters.get(AccessCounters::GET);
+		stats.insert = counters.get(AccessCounters::INSERT);
+		stats.remove = counters.get(AccessCounters::REMOVE);
+		return stats;
+	}
+
+	// Start a new round of call counting, usually once per frame
+	void reset_counters()
+	{
+		counters.reset();
+	}
+
+	// Append the entities and components to a snapshot
+	// Trivially copyable components are copied as one block, others need a pair of functions
+	// void save(Snapshot&, const Component&) and void load(Snapshot&, Component&), see components.hpp
+	void snapshot(Snapshot& snapshot) const
+	{
+		snapshot.write_array(entities);
+		if constexpr (std::is_trivially_copyable<Component>::value && !stable)
+			snapshot.write_array(components);
+		else
+			for (size_t i = 0; i < components.size(); i++)
+				save_component(snapshot, components[i]);
+	}
+
+	// Replace the content by the one captured in a snapshot
+	// Note, no signals are emitted and the signatures are restored by the registry, the groups by the owner.
+	void restore(Snapshot& snapshot)
+	{
+		clear_updated();
+		for (Entity e : entities)
+			sparse_slot(e) = npos;
+		snapshot.read_array(entities);
+		if constexpr (std::is_trivially_copyable<Component>::value && !stable)
+			snapshot.read_array(components);
+		else
+		{
+			components.clear();
+			components.reserve(entities.size());
+			for (size_t i = 0; i < entities.size(); i++)
+				components.push_back(load_component(snapshot));
+		}
+		for (unsigned int i = 0; i < entities.size(); i++)
+			sparse_slot(entities[i]) = i;
+	}
+
+	// The position of an entity in the dense arrays, the entity must be contained
+	unsigned int index_of(Entity e)
+	{
+		assert(dense_index(e) != npos && "Entity not contained in ECS registry");
+		return dense_index(e);
+	}
+
+	// Swap the components and entities at positions a and b of the dense arrays
+	void swap_dense(unsigned int a, unsigned int b)
+	{
+		if (a == b)
+			return;
+		swap_components(a, b);
+		std::swap(entities[a], entities[b]);
+		sparse_slot(entities[a]) = a;
+		sparse_slot(entities[b]) = b;
+	}
+
 	// Sort the components and associated entity assignment structures by the comparisonFunction, see std::sort
+	// The comparison gets two entities and may read any container through them, this one included, as only
+	// a list of dense positions is sorted. It must not add or remove components. Afterwards the entities and
+	// components follow in place along the cycles of the permutation. Already sorted containers return after a
+	// single pass.
 	template <class Compare>
 	void sort(Compare comparisonFunction)
 	{
-		// First sort the entity list as desired
-		std::sort(entities.begin(), entities.end(), comparisonFunction);
-		// Now re-arrange the components (Note, creates a new vector, which may be slow! Not sure if in-place could be faster: https://stackoverflow.com/questions/63703637/how-to-efficiently-permute-an-array-in-place-using-stdswap)
-		std::vector<Component> components_new; components_new.reserve(components.size());
-		std::transform(entities.begin(), entities.end(), std::back_inserter(components_new), [&](Entity e) { return std::move(get(e)); }); // note, the get still uses the old hash map (on purpose!)
-		components = std::move(components_new); // note, we use move operations to not create unneccesary copies of objects, but memory is still allocated for the new vector
-		// Fill the new hashmap
-		for (unsigned int i = 0; i < entities.size(); i++)
-			map_entity_componentID[entities[i]] = i;
+		assert(groups.empty() && "Can't sort a container that is arranged by a group");
+		if (std::is_sorted(entities.begin(), entities.end(), comparisonFunction))
+			return;
+		reset_order();
+		std::sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) { return comparisonFunction(entities[a], entities[b]); });
+		apply_order();
+	}
+
+	// Sort like sort(), but with an insertion sort that is linear for nearly sorted containers,
+	// e.g. when sprites are kept in render order and only a few of them moved since the last frame
+	template <class Compare>
+	void sort_incremental(Compare comparisonFunction)
+	{
+		assert(groups.empty() && "Can't sort a container that is arranged by a group");
+		if (std::is_sorted(entities.begin(), entities.end(), comparisonFunction))
+			return;
+		reset_order();
+		for (unsigned int i = 1; i < order.size(); i++)
+		{
+			unsigned int moved = order[i];
+			unsigned int j = i;
+			for (; j > 0 && comparisonFunction(entities[moved], entities[order[j - 1]]); j--)
+				order[j] = order[j - 1];
+			order[j] = moved;
+		}
+		apply_order();
+	}
+};
+
+// A container for tag components, i.e. empty structs that only mark an entity
+// Instead of component and entity arrays it keeps one bit per entity index, so has() is a bit test, the
+// size is tracked on the way and the entities are found by scanning the bitset a 64-bit word at a time.
+// All entities share a single instance of the empty component.
+template <typename Component>
+class TagContainer
+{
+	static_assert(std::is_empty<Component>::value, "Tag components must not have any data");
+
+	std::vector<uint64_t> bits;
+	unsigned int count = 0;
+	static inline Component instance;
+	AccessCounters counters;
+
+	// A bit test, plus the generation check that rejects stale handles
+	bool tagged(Entity e) const
+	{
+		unsigned int index = e.index();
+		return index / 64 < bits.size() && (bits[index / 64] >> (index % 64) & 1) && Entity::is_alive(e);
+	}
+
+public:
+	// Iterates the tagged entities in index order, it stays valid when the current entity is removed
+	class Iterator
+	{
+		const std::vector<uint64_t>* bits;
+		size_t word;
+		uint64_t remaining;
+
+		void skip_empty_words()
+		{
+			while (remaining == 0 && ++word < bits->size())
+				remaining = (*bits)[word];
+		}
+	public:
+		Iterator(const std::vector<uint64_t>* bits, size_t word)
+			: bits(bits), word(word), remaining(word < bits->size() ? (*bits)[word] : 0)
+		{
+			if (word < bits->size())
+				skip_empty_words();
+		}
+		Entity operator*() const { return Entity::from_index((unsigned int)(word * 64 + lowest_bit(remaining))); }
+		Iterator& operator++()
+		{
+			remaining &= remaining - 1;
+			skip_empty_words();
+			return *this;
+		}
+		bool operator==(const Iterator& other) const { return word == other.word && remaining == other.remaining; }
+		bool operator!=(const Iterator& other) const { return !(*this == other); }
+	};
+
+	// The tagged entities, usable like the entities vector of a ComponentContainer
+	class EntityRange
+	{
+		TagContainer& tags;
+	public:
+		EntityRange(TagContainer& tags) : tags(tags) {}
+		Iterator begin() const { return Iterator(&tags.bits, 0); }
+		Iterator end() const { return Iterator(&tags.bits, tags.bits.size()); }
+		size_t size() const { return tags.count; }
+		bool empty() const { return tags.count == 0; }
+		Entity front() const { return *begin(); }
+		Entity back() const
+		{
+			assert(!empty());
+			size_t word = tags.bits.size() - 1;
+			while (tags.bits[word] == 0)
+				word--;
+			return Entity::from_index((unsigned int)(word * 64 + highest_bit(tags.bits[word])));
+		}
+		// The i-th tagged entity in index order, found by counting the bits of whole words first
+		Entity operator[](size_t i) const
+		{
+			assert(i < size());
+			size_t word = 0;
+			for (unsigned int n = bit_count(tags.bits[word]); i >= n; n = bit_count(tags.bits[word]))
+			{
+				i -= n;
+				word++;
+			}
+			uint64_t remaining = tags.bits[word];
+			for (; i > 0; i--)
+				remaining &= remaining - 1;
+			return Entity::from_index((unsigned int)(word * 64 + lowest_bit(remaining)));
+		}
+	};
+	EntityRange entities{ *this };
+
+	// Same signals as ComponentContainer, a tag can't be patched so on_update is never emitted
+	Signal on_construct;
+	Signal on_update;
+	Signal on_destroy;
+
+	// The signature table this container keeps up to date and the bit of its component type
+	SignatureTable* signatures = nullptr;
+	unsigned int signature_bit = 0;
+
+	TagContainer() {}
+	// The entity range refers to this container
+	TagContainer(const TagContainer&) = delete;
+	TagContainer& operator=(const TagContainer&) = delete;
+
+	// Tag entity e
+	Component& insert(Entity e, Component = Component(), bool check_for_duplicates = true)
+	{
+		assert(!(check_for_duplicates && tagged(e)) && "Entity already contained in ECS registry");
+		assert(Entity::is_alive(e) && "Entity was already destroyed");
+		counters.count(AccessCounters::INSERT);
+		unsigned int index = e.index();
+		if (index / 64 >= bits.size())
+			bits.resize(index / 64 + 1, 0);
+		uint64_t bit = uint64_t(1) << (index % 64);
+		if (!(bits[index / 64] & bit))
+		{
+			bits[index / 64] |= bit;
+			count++;
+		}
+		if (signatures)
+			signatures->set(e, signature_bit);
+		on_construct.emit(e);
+		return instance;
+	}
+	template<typename... Args>
+	Component& emplace(Entity e, Args &&...) {
+		return insert(e);
+	};
+
+	Component& get(Entity e) {
+		counters.count(AccessCounters::GET);
+		assert(tagged(e) && "Entity not contained in ECS registry");
+		return instance;
+	}
+	Component* try_get(Entity e) {
+		counters.count(AccessCounters::GET);
+		return tagged(e) ? &instance : nullptr;
+	}
+
+	bool has(Entity e) {
+		counters.count(AccessCounters::HAS);
+		return tagged(e);
+	}
+
+	void remove(Entity e)
+	{
+		counters.count(AccessCounters::REMOVE);
+		if (!tagged(e))
+			return;
+		on_destroy.emit(e);
+		unsigned int index = e.index();
+		bits[index / 64] &= ~(uint64_t(1) << (index % 64));
+		count--;
+		if (signatures)
+			signatures->reset(e, signature_bit);
+	}
+
+	void clear()
+	{
+		if (!on_destroy.empty() || signatures)
+		{
+			for (Entity e : entities)
+				remove(e);
+		}
+		std::fill(bits.begin(), bits.end(), 0);
+		count = 0;
+	}
+
+	// Untag all entities that satisfy pred(Entity) in a single pass, see ComponentContainer::remove_if
+	template <typename Predicate>
+	void remove_if(Predicate pred, std::vector<Entity>& removed)
+	{
+		for (size_t word = 0; word < bits.size(); word++)
+		{
+			for (uint64_t remaining = bits[word]; remaining != 0; remaining &= remaining - 1)
+			{
+				unsigned int bit = lowest_bit(remaining);
+				Entity e = Entity::from_index((unsigned int)(word * 64 + bit));
+				if (!pred(e))
+					continue;
+				bits[word] &= ~(uint64_t(1) << bit);
+				count--;
+				if (signatures)
+					signatures->reset(e, signature_bit);
+				if (!on_destroy.empty())
+					removed.push_back(e);
+			}
+		}
+	}
+
+	size_t size()
+	{
+		return count;
+	}
+
+	// The bitset grows with the entity indices rather than the number of tags, there is nothing to reserve
+	void reserve(size_t)
+	{
+	}
+
+	// The bitset has a slot for every entity index up to the highest tagged one
+	ContainerStats stats() const
+	{
+		ContainerStats stats;
+		stats.name = typeid(Component).name();
+		stats.size = count;
+		stats.capacity = bits.size() * 64;
+		stats.bytes = bits.capacity() * sizeof(uint64_t);
+		if (!bits.empty())
+			stats.sparse_occupancy = (float)count / (float)stats.capacity;
+		stats.has = counters.get(AccessCounters::HAS);
+		stats.get = counters.get(AccessCounters::GET);
+		stats.insert = counters.get(AccessCounters::INSERT);
+		stats.remove = counters.get(AccessCounters::REMOVE);
+		return stats;
+	}
+
+	void reset_counters()
+	{
+		counters.reset();
+	}
+
+	// Tags don't change, there is nothing to track
+	void clear_updated()
+	{
+	}
+
+	// The bitset is the whole content
+	void snapshot(Snapshot& snapshot) const
+	{
+		snapshot.write_array(bits);
+	}
+	void restore(Snapshot& snapshot)
+	{
+		snapshot.read_array(bits);
+		count = 0;
+		for (uint64_t word : bits)
+			count += bit_count(word);
+	}
+};
+
+// The container type that stores components of type 'Component', tags without data get a bitset
+template <typename Component>
+using Storage = typename std::conditional<std::is_empty<Component>::value, TagContainer<Component>, ComponentContainer<Component>>::type;
+
+// An owning group keeps the entities that have both a 'Shared' and a 'Partner' component in lockstep:
+// they are packed at the front of the partner container, and in the same order in a segment of the
+// shared container, so that the i-th partner component belongs to the same entity as the i-th shared
+// component of the segment. Loops over the group are linear sweeps without lookups.
+// Several groups may share a container as long as their partner components never meet on an entity,
+// each group then owns a segment in the order the groups were created. The partner container is owned
+// by this group alone. Adding or removing group members moves the segments behind it by one element.
+template <typename Shared, typename Partner>
+class OwningGroup : public GroupInterface
+{
+	ComponentContainer<Shared>& shared;
+	ComponentContainer<Partner>& partner;
+	unsigned int count = 0;
+	std::array<unsigned int, 4> connections;
+
+	bool contains(Entity e)
+	{
+		return partner.has(e) && partner.index_of(e) < count;
+	}
+
+	// The end of the last segment of the shared container
+	unsigned int segments_end()
+	{
+		unsigned int end = 0;
+		for (GroupInterface* group : shared.groups)
+			end += (unsigned int)group->size();
+		return end;
+	}
+
+public:
+	OwningGroup(ComponentContainer<Shared>& shared, ComponentContainer<Partner>& partner)
+		: shared(shared)
+		, partner(partner)
+	{
+		assert(partner.groups.empty() && "Container is already owned by another group");
+		shared.groups.push_back(this);
+		partner.groups.push_back(this);
+		connections = { {
+			shared.on_construct.connect([this](Entity e) { on_insert(e); }),
+			partner.on_construct.connect([this](Entity e) { on_insert(e); }),
+			shared.on_destroy.connect([this](Entity e) { on_remove(e); }),
+			partner.on_destroy.connect([this](Entity e) { on_remove(e); }),
+		} };
+		for (unsigned int i = 0; i < partner.entities.size(); i++)
+			on_insert(partner.entities[i]);
+	}
+
+	OwningGroup(const OwningGroup&) = delete;
+	OwningGroup& operator=(const OwningGroup&) = delete;
+
+	~OwningGroup()
+	{
+		shared.on_construct.disconnect(connections[0]);
+		partner.on_construct.disconnect(connections[1]);
+		shared.on_destroy.disconnect(connections[2]);
+		partner.on_destroy.disconnect(connections[3]);
+	}
+
+	// Keep the group up to date, called after e was added to and before it is removed from one of the containers
+
+	void on_insert(Entity e)
+	{
+		if (contains(e) || !shared.has(e) || !partner.has(e))
+			return;
+		unsigned int first = begin(), end = segments_end();
+		assert(shared.index_of(e) >= end && "Entity is already part of another group");
+		partner.swap_dense(partner.index_of(e), count);
+		// Move e right behind the last segment, then shift the segments behind this one to the right
+		shared.swap_dense(shared.index_of(e), end);
+		for (unsigned int i = end; i > first + count; i--)
+			shared.swap_dense(i, i - 1);
+		count++;
+	}
+
+	void on_remove(Entity e)
+	{
+		if (!contains(e))
+			return;
+		unsigned int first = begin(), end = segments_end();
+		unsigned int i = partner.index_of(e);
+		// Move e to the end of this segment, then shift the segments behind this one to the left
+		partner.swap_dense(i, count - 1);
+		shared.swap_dense(first + i, first + count - 1);
+		for (unsigned int j = first + count - 1; j + 1 < end; j++)
+			shared.swap_dense(j, j + 1);
+		count--;
+	}
+
+	// Report the number of entities in the group
+	size_t size()
+	{
+		return count;
+	}
+
+	// The members are still packed at the front of the partner container, only the count is lost
+	void restore()
+	{
+		count = 0;
+		while (count < partner.entities.size() && shared.has(partner.entities[count]))
+			count++;
+	}
+
+	// The range [begin(), end()) of the group's segment in the shared container
+	unsigned int begin()
+	{
+		unsigned int first = 0;
+		for (GroupInterface* group : shared.groups)
+		{
+			if (group == this)
+				break;
+			first += (unsigned int)group->size();
+		}
+		return first;
+	}
+	unsigned int end()
+	{
+		return begin() + count;
+	}
+
+	// The i-th entity of the group and its components, i in [0, size())
+	Entity entity(unsigned int i)
+	{
+		return partner.entities[i];
+	}
+	template <typename Component>
+	Component& get(unsigned int i)
+	{
+		return get(i, (Component*)nullptr);
+	}
+
+	// Calls fn(Entity, Shared&, Partner&) for every entity in the group
+	template <typename Function>
+	void each(Function fn)
+	{
+		unsigned int first = begin();
+		for (unsigned int i = 0; i < count; i++)
+			fn(partner.entities[i], shared.components[first + i], partner.components[i]);
+	}
+
+private:
+	Shared& get(unsigned int i, Shared*)
+	{
+		return shared.components[begin() + i];
+	}
+	Partner& get(unsigned int i, Partner*)
+	{
+		return partner.components[i];
+	}
+};
+
+// The list of excluded component types of a view, see ComponentView::exclude
+template <typename... Exclude>
+struct ExcludeList {};
+
+// A view over all entities that have every component in 'Component' and none of the excluded ones.
+// It walks the smallest of the included containers and matches the entity signatures against the view,
+// so a loop costs as much as the rarest component and entities that don't match need no lookups at all.
+// Note, components of the viewed types must not be added or removed while iterating.
+template <typename Registry, typename Exclude, typename... Component>
+class ComponentView;
+
+template <typename Registry, typename... Exclude, typename... Component>
+class ComponentView<Registry, ExcludeList<Exclude...>, Component...>
+{
+	Registry& registry;
+	std::tuple<Storage<Component>&...> included;
+
+	template <size_t I>
+	using ComponentAt = typename std::tuple_element<I, std::tuple<Component...>>::type;
+
+	// The position of the included container with the fewest entities
+	template <size_t... I>
+	size_t smallest(std::index_sequence<I...>) const
+	{
+		std::array<size_t, sizeof...(Component)> sizes = { { std::get<I>(included).size()... } };
+		return std::min_element(sizes.begin(), sizes.end()) - sizes.begin();
+	}
+
+	// The same for the containers that can be split into ranges, i.e. the ones that aren't tag containers
+	template <size_t... I>
+	size_t smallest_with_data(std::index_sequence<I...>) const
+	{
+		std::array<size_t, sizeof...(Component)> sizes = { {
+			(std::is_empty<ComponentAt<I>>::value ? ~size_t(0) : std::get<I>(included).size())... } };
+		return std::min_element(sizes.begin(), sizes.end()) - sizes.begin();
+	}
+
+	// The component of the i-th entity of the iterated container D, which needs no lookup in that container
+	template <size_t I, size_t D>
+	decltype(auto) fetch(size_t i, Entity e)
+	{
+		if constexpr (I == D)
+			return (std::get<I>(included).components[i]);
+		else
+			return (std::get<I>(included).get(e));
+	}
+
+	template <typename Function, size_t... I>
+	void each(Function& fn, std::index_sequence<I...> indices)
+	{
+		size_t iterated = smallest(indices);
+		((I == iterated ? each_from<I>(fn, indices) : void()), ...);
+	}
+
+	// Walk the D-th included container and match the entities against the view
+	template <size_t D, typename Function, size_t... I>
+	void each_from(Function& fn, std::index_sequence<I...> indices)
+	{
+		auto& pool = std::get<D>(included);
+		if constexpr (std::is_empty<ComponentAt<D>>::value)
+		{
+			const SignatureTable& signatures = registry.signatures;
+			constexpr uint64_t include = Registry::template signature_of<Component...>();
+			constexpr uint64_t exclude = Registry::template signature_of<Exclude...>();
+			for (Entity entity : pool.entities)
+			{
+				uint64_t signature = signatures.get_alive(entity);
+				if ((signature & include) == include && (signature & exclude) == 0)
+					fn(entity, std::get<I>(included).get(entity)...);
+			}
+		}
+		else
+			each_in<D>(fn, 0, pool.entities.size(), indices);
+	}
+
+	// Walk the positions [begin, end) of the D-th included container, which has components with data
+	template <size_t D, typename Function, size_t... I>
+	void each_in(Function& fn, size_t begin, size_t end, std::index_sequence<I...>)
+	{
+		auto& pool = std::get<D>(included);
+		const SignatureTable& signatures = registry.signatures;
+		constexpr uint64_t include = Registry::template signature_of<Component...>();
+		constexpr uint64_t exclude = Registry::template signature_of<Exclude...>();
+		if constexpr (sizeof...(Component) == 1 && sizeof...(Exclude) == 0)
+		{
+			// A single component without exclusions is a plain sweep over its container
+			for (size_t i = begin; i < end; i++)
+				fn(pool.entities[i], pool.components[i]);
+		}
+		else
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				Entity entity = pool.entities[i];
+				uint64_t signature = signatures.get_alive(entity);
+				if ((signature & include) == include && (signature & exclude) == 0)
+					fn(entity, fetch<I, D>(i, entity)...);
+			}
+		}
+	}
+
+	template <typename Function, size_t... I>
+	void parallel_each(Function& fn, size_t min_range, std::index_sequence<I...> indices)
+	{
+		size_t iterated = smallest_with_data(indices);
+		((I == iterated ? parallel_from<I>(fn, min_range, indices) : void()), ...);
+	}
+
+	// Split the D-th included container into ranges
+	// Components in a vector are split at whole cache lines, so two threads never write to the same line.
+	// Components at stable addresses sit in pages in allocation order, which the ranges can't line up with.
+	template <size_t D, typename Function, size_t... I>
+	void parallel_from(Function& fn, size_t min_range, std::index_sequence<I...> indices)
+	{
+		using Container = typename std::remove_reference<decltype(std::get<D>(included))>::type;
+		if constexpr (!std::is_empty<ComponentAt<D>>::value)
+		{
+			size_t line = Container::stable ? 1 : 64 / std::gcd<size_t>(64, sizeof(ComponentAt<D>)); // components per whole cache lines
+			size_t range = std::max<size_t>((min_range + line - 1) / line, 1) * line;
+			registry.run_parallel(std::get<D>(included).entities.size(), range, [&](size_t begin, size_t end) {
+				each_in<D>(fn, begin, end, indices);
+			});
+		}
+	}
+
+public:
+	ComponentView(Registry& registry)
+		: registry(registry)
+		, included(registry.template get<Component>()...)
+	{
+	}
+
+	// Returns a view that additionally skips entities with any of the components 'More'
+	template <typename... More>
+	ComponentView<Registry, ExcludeList<Exclude..., More...>, Component...> exclude() const
+	{
+		return ComponentView<Registry, ExcludeList<Exclude..., More...>, Component...>(registry);
+	}
+
+	// Calls fn(Entity, Component&...) for every entity in the view
+	template <typename Function>
+	void each(Function fn)
+	{
+		each(fn, std::index_sequence_for<Component...>{});
+	}
+
+	// Like each, but the entities are split into ranges that the worker pool runs in parallel
+	// A range has at least min_range entities, so small containers stay on the calling thread. fn may only
+	// change the components of its own entity and records structural changes, see ComponentRegistry::commands.
+	template <typename Function>
+	void parallel_each(Function fn, size_t min_range = 1024)
+	{
+		static_assert(!(std::is_empty<Component>::value && ...), "A parallel view needs a component with data");
+		parallel_each(fn, min_range, std::index_sequence_for<Component...>{});
+	}
+};
+
+// Records structural changes, i.e. destroying entities, inserting and removing components and running
+// entity creation functions, and applies them later in one batch at a sync point. Systems can then make
+// these changes while iterating containers without invalidating the iteration.
+// Every thread records into its own buffer, see ComponentRegistry::commands.
+template <typename Registry>
+class CommandBuffer
+{
+	std::vector<std::function<void(Registry&)>> commands;
+	std::vector<std::function<void(Registry&)>> applying; // kept to re-use its memory
+
+public:
+	// Run an entity creation function at the flush, e.g. create([=]() { createHeart(renderer, pos); })
+	template <typename Function>
+	void create(Function fn)
+	{
+		commands.emplace_back([fn](Registry&) { fn(); });
+	}
+
+	// Remove all components of an entity at the flush
+	void destroy(Entity e)
+	{
+		commands.emplace_back([e](Registry& registry) { registry.remove_all_components_of(e); });
+	}
+
+	// Insert or remove a component at the flush, nothing happens if the entity was destroyed in the meantime
+	template <typename Component>
+	void insert(Entity e, Component c)
+	{
+		commands.emplace_back([e, c](Registry& registry) {
+			if (Entity::is_alive(e))
+				registry.template get<Component>().insert(e, c);
+		});
+	}
+	template <typename Component>
+	void remove(Entity e)
+	{
+		commands.emplace_back([e](Registry& registry) { registry.template get<Component>().remove(e); });
+	}
+
+	// Insert a component at the flush unless the entity got one of the type in the meantime
+	template <typename Component>
+	void insert_if_missing(Entity e, Component c)
+	{
+		commands.emplace_back([e, c](Registry& registry) {
+			if (Entity::is_alive(e) && !registry.template get<Component>().has(e))
+				registry.template get<Component>().insert(e, c);
+		});
+	}
+
+	bool empty() const
+	{
+		return commands.empty();
+	}
+
+	// Move the commands of another buffer to the end of this one
+	void append(CommandBuffer& other)
+	{
+		for (std::function<void(Registry&)>& command : other.commands)
+			commands.push_back(std::move(command));
+		other.commands.clear();
+	}
+
+	// Apply the recorded commands in order, including the ones they record themselves
+	void apply(Registry& registry)
+	{
+		while (!commands.empty())
+		{
+			applying.swap(commands);
+			for (std::function<void(Registry&)>& command : applying)
+				command(registry);
+			applying.clear();
+		}
+	}
+};
+
+// A pre-built bundle of components, e.g. the blueprint of a pickup
+// Instantiating it copies the components into the containers of a new entity, so spawning needs no
+// per-field setup. Adjust the copies afterwards for what differs between instances, e.g. the position.
+template <typename... Component>
+class Prefab
+{
+public:
+	std::tuple<Component...> components;
+
+	Prefab(Component... components) : components(std::move(components)...) {}
+
+	template <typename T>
+	T& get()
+	{
+		return std::get<T>(components);
+	}
+
+	// Create an entity with a copy of every component
+	template <typename Registry>
+	Entity instantiate(Registry& registry) const
+	{
+		Entity e;
+		std::apply([&](const Component&... c) { (registry.template get<Component>().insert(e, c), ...); }, components);
+		return e;
+	}
+
+	// Create count entities at once, fn(i, Entity) is called for each of them, e.g. to place it
+	template <typename Registry, typename Function>
+	void instantiate(Registry& registry, size_t count, Function fn) const
+	{
+		Entity::reserve(count);
+		(registry.template get<Component>().reserve(registry.template get<Component>().size() + count), ...);
+		for (size_t i = 0; i < count; i++)
+			fn(i, instantiate(registry));
+	}
+};
+
+// Position of type T in a list of types that contains it exactly once
+template <typename T, typename... List>
+struct type_index;
+template <typename T, typename... Rest>
+struct type_index<T, T, Rest...> : std::integral_constant<unsigned int, 0> {};
+template <typename T, typename U, typename... Rest>
+struct type_index<T, U, Rest...> : std::integral_constant<unsigned int, 1 + type_index<T, Rest...>::value> {};
+
+// A registry with one container for each of the component types in 'Component'
+// The type ids are the positions in the list, so every per-type operation resolves to its container at
+// compile time and a new component type can't be left out of clear or remove.
+template <typename... Component>
+class ComponentRegistry
+{
+	std::tuple<Storage<Component>...> containers;
+
+	// The command buffers of all threads that recorded into this registry
+	std::vector<std::unique_ptr<CommandBuffer<ComponentRegistry>>> command_buffers;
+	std::recursive_mutex command_buffers_mutex; // recursive, applying a command may create the buffer of the flushing thread
+	// A buffer per range of the running parallel loop, see run_parallel
+	std::vector<std::unique_ptr<CommandBuffer<ComponentRegistry>>> range_buffers;
+
+	// The buffer of the parallel loop range the calling thread is running, if any
+	static CommandBuffer<ComponentRegistry>*& range_commands()
+	{
+		thread_local CommandBuffer<ComponentRegistry>* buffer = nullptr;
+		return buffer;
+	}
+
+public:
+	static_assert(sizeof...(Component) <= SignatureTable::max_types, "Too many component types for the entity signature");
+
+	// The id of component type T, which is also its bit in the entity signatures
+	template <typename T>
+	static constexpr unsigned int type_id = type_index<T, Component...>::value;
+
+	// The component types of every entity
+	SignatureTable signatures;
+
+	// Called after restore(), which replaces the containers without emitting their signals
+	BasicSignal<> on_restore;
+
+	ComponentRegistry()
+	{
+		((get<Component>().signatures = &signatures, get<Component>().signature_bit = type_id<Component>), ...);
+	}
+	// The containers refer to the signature table, so the registry can't be copied
+	ComponentRegistry(const ComponentRegistry&) = delete;
+	ComponentRegistry& operator=(const ComponentRegistry&) = delete;
+
+	// Returns the container of components of type T
+	template <typename T>
+	Storage<T>& get()
+	{
+		return std::get<type_id<T>>(containers);
+	}
+
+	// The component types an entity owns, see signature_of
+	uint64_t signature(Entity e)
+	{
+		return signatures.get(e);
+	}
+
+	// The signature bits of the component types
+	template <typename... T>
+	static constexpr uint64_t signature_of()
+	{
+		return (uint64_t(0) | ... | (uint64_t(1) << type_id<T>));
+	}
+
+	// Check if an entity has all, or any, of the component types
+	template <typename... T>
+	bool has_all(Entity e)
+	{
+		return (signature(e) & signature_of<T...>()) == signature_of<T...>();
+	}
+	template <typename... T>
+	bool has_any(Entity e)
+	{
+		return (signature(e) & signature_of<T...>()) != 0;
+	}
+
+	// A view over all entities that have every one of the components, e.g.
+	// registry.view<Motion, Gravity>().exclude<Spikeball>().each([](Entity e, Motion& m, Gravity& g) { ... });
+	template <typename... T>
+	ComponentView<ComponentRegistry, ExcludeList<>, T...> view()
+	{
+		return ComponentView<ComponentRegistry, ExcludeList<>, T...>(*this);
+	}
+
+	// Like view<T...>().each(fn), with the entities split into ranges that run in parallel, e.g.
+	// registry.parallel_each<Motion>([=](Entity e, Motion& m) { m.position += m.velocity * step_seconds; });
+	// Results are the same as for each() as long as fn only works on its own entity, see ComponentView::parallel_each
+	template <typename... T, typename Function>
+	void parallel_each(Function fn)
+	{
+		view<T...>().parallel_each(fn);
+	}
+
+	// Create count entities that have the components T..., e.g. the tiles of a level
+	// Every involved container is reserved once, then fn(i, T&...) fills in the components of the i-th entity
+	// before they are inserted.
+	template <typename... T, typename Function>
+	void create_many(size_t count, Function fn)
+	{
+		Entity::reserve(count);
+		(get<T>().reserve(get<T>().size() + count), ...);
+		for (size_t i = 0; i < count; i++)
+		{
+			Entity e;
+			std::tuple<T...> components;
+			std::apply([&](T&... c) { fn(i, c...); }, components);
+			(get<T>().insert(e, std::move(std::get<T>(components))), ...);
+		}
+	}
+
+	// The command buffer of the calling thread, created on first use
+	// Within a parallel loop it's the buffer of the current range instead, see run_parallel.
+	// Note, there is one buffer per thread and registry type, so a program should have a single registry
+	CommandBuffer<ComponentRegistry>& commands()
+	{
+		if (range_commands())
+			return *range_commands();
+		thread_local CommandBuffer<ComponentRegistry>* buffer = nullptr;
+		if (!buffer)
+		{
+			std::lock_guard<std::recursive_mutex> lock(command_buffers_mutex);
+			command_buffers.emplace_back(new CommandBuffer<ComponentRegistry>());
+			buffer = command_buffers.back().get();
+		}
+		return *buffer;
+	}
+
+	// Run fn(begin, end) for the ranges of [0, count) on the worker pool, see ComponentView::parallel_each
+	// Every range records its commands into a buffer of its own, and these are moved to the buffer of the calling
+	// thread in range order. The commands end up in the same order however the ranges were spread over the threads.
+	// Note, parallel loops are started by one thread at a time, a nested loop runs within its enclosing range.
+	template <typename Function>
+	void run_parallel(size_t count, size_t range, Function fn)
+	{
+		if (range_commands())
+		{
+			for (size_t begin = 0; begin < count; begin += range)
+				fn(begin, std::min(begin + range, count));
+			return;
+		}
+
+		size_t ranges = (count + range - 1) / range;
+		while (range_buffers.size() < ranges)
+			range_buffers.emplace_back(new CommandBuffer<ComponentRegistry>());
+		WorkerPool::shared().run(count, range, [&](size_t begin, size_t end) {
+			range_commands() = range_buffers[begin / range].get();
+			fn(begin, end);
+			range_commands() = nullptr;
+		});
+
+		CommandBuffer<ComponentRegistry>& buffer = commands();
+		for (size_t i = 0; i < ranges; i++)
+			buffer.append(*range_buffers[i]);
+	}
+
+	// Apply the commands recorded by all threads, this is the sync point where no thread may be recording
+	void flush_commands()
+	{
+		std::lock_guard<std::recursive_mutex> lock(command_buffers_mutex);
+		for (size_t i = 0; i < command_buffers.size(); i++)
+			command_buffers[i]->apply(*this);
+	}
+
+	void clear_all_components()
+	{
+		(get<Component>().clear(), ...);
+	}
+
+	// Start a new round of change tracking in all containers, see ComponentContainer::patch
+	void clear_updated()
+	{
+		(get<Component>().clear_updated(), ...);
+	}
+
+	// The statistics of every container, e.g. for tests or a debug overlay, see ContainerStats
+	// The call counts are those since the last reset_counters(), which the game calls once per frame.
+	void stats(RegistryStats& stats)
+	{
+		stats.containers.clear();
+		(stats.containers.push_back(get<Component>().stats()), ...);
+		stats.bytes = signatures.bytes();
+		for (const ContainerStats& container : stats.containers)
+			stats.bytes += container.bytes;
+	}
+	RegistryStats stats()
+	{
+		RegistryStats result;
+		stats(result);
+		return result;
+	}
+
+	void reset_counters()
+	{
+		(get<Component>().reset_counters(), ...);
+	}
+
+	void list_all_components()
+	{
+		RegistryStats all = stats();
+		printf("Debug info on all registry entries, %zu bytes:\n", all.bytes);
+		for (const ContainerStats& container : all.containers)
+		{
+			if (container.size == 0)
+				continue;
+			printf("%4d components of type %s, capacity %d, %zu bytes, sparse occupancy %.2f\n",
+				(int)container.size, container.name, (int)container.capacity, container.bytes, container.sparse_occupancy);
+#ifdef ECS_INSTRUMENTATION
+			printf("     calls has %llu get %llu insert %llu remove %llu\n",
+				(unsigned long long)container.has, (unsigned long long)container.get,
+				(unsigned long long)container.insert, (unsigned long long)container.remove);
+#endif
+		}
+	}
+
+	void list_all_components_of(Entity e)
+	{
+		printf("Debug info on components of entity %u:\n", (unsigned int)e);
+		uint64_t bits = signature(e);
+		(((bits & signature_of<Component>()) != 0 ? (void)printf("type %s\n", typeid(Storage<Component>).name()) : (void)0), ...);
+	}
+
+	// Capture all entities and components in one contiguous buffer, e.g. for tests, tools and rollback
+	// The memory of the snapshot is re-used, so capturing every frame doesn't allocate.
+	void snapshot(Snapshot& snapshot)
+	{
+		snapshot.clear();
+		Entity::snapshot(snapshot);
+		signatures.snapshot(snapshot);
+		(get<Component>().snapshot(snapshot), ...);
+	}
+	Snapshot snapshot()
+	{
+		Snapshot result;
+		snapshot(result);
+		return result;
+	}
+
+	// Bring back the state of a snapshot, entities created since then become stale
+	// Note, the pending commands are not part of a snapshot, flush or drop them first.
+	void restore(Snapshot& snapshot)
+	{
+		snapshot.rewind();
+		Entity::restore(snapshot);
+		signatures.restore(snapshot);
+		(get<Component>().restore(snapshot), ...);
+		(restore_groups(get<Component>()), ...);
+		on_restore.emit();
+	}
+
+	void remove_all_components_of(Entity e)
+	{
+		// Only touch the containers the entity has a component in
+		uint64_t bits = signature(e);
+		(((bits & signature_of<Component>()) != 0 ? get<Component>().remove(e) : (void)0), ...);
+		// The entity is gone from every container, its index can be handed out again
+		Entity::release(e);
+	}
+
+	// Remove all entities of a scope, e.g. everything a level created, see Entity::enter_scope
+	// Instead of taking the entities out one by one, every container is swept once and the groups are
+	// recounted afterwards. The on_destroy signals are emitted after the sweep, while the handles are still
+	// alive, and the entities also go if they have no components at all.
+	void destroy_scope(unsigned char scope)
+	{
+		std::array<std::vector<Entity>, sizeof...(Component)> removed;
+		auto in_scope = [scope](Entity e) { return Entity::scope_of(e) == scope; };
+		(get<Component>().remove_if(in_scope, removed[type_id<Component>]), ...);
+		(restore_groups(get<Component>()), ...);
+		((emit_all(get<Component>().on_destroy, removed[type_id<Component>])), ...);
+		Entity::release_scope(scope);
+	}
+
+private:
+	template <typename T>
+	void restore_groups(ComponentContainer<T>& container)
+	{
+		for (GroupInterface* group : container.groups)
+			group->restore();
+	}
+	template <typename T>
+	void restore_groups(TagContainer<T>&)
+	{
+	}
+
+	static void emit_all(Signal& signal, const std::vector<Entity>& entities)
+	{
+		for (Entity e : entities)
+			signal.emit(e);
 	}
 };
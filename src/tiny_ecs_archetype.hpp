@@ -0,0 +1,399 @@
+#pragma once
+
+#include <new>
+
+#include "tiny_ecs.hpp"
+
+// Archetype storage, an alternative backend to the per-type containers of ComponentRegistry.
+// Entities with the same set of components share an archetype, which stores them in fixed-size chunks
+// with one column per component. A query like each<Motion, Gravity, NormalZombie> walks the matching
+// archetypes and streams through their columns, without any lookups. In exchange adding or removing
+// a component moves the entity with all its components to another archetype.
+// Note, the game uses ComponentRegistry, this backend is opt-in.
+
+// How to move and destroy the components of a column without knowing their type
+struct ArchetypeColumnType
+{
+	size_t size;
+	size_t align;
+	bool empty; // tags have no column
+	void (*move_construct)(void* dst, void* src);
+	void (*destroy)(void* p);
+};
+
+template <typename T>
+ArchetypeColumnType archetype_column_type()
+{
+	return { sizeof(T), alignof(T), std::is_empty<T>::value,
+		[](void* dst, void* src) { new (dst) T(std::move(*static_cast<T*>(src))); },
+		[](void* p) { static_cast<T*>(p)->~T(); } };
+}
+
+// A registry that keeps the components of 'Component' in archetype chunks
+template <typename... Component>
+class ArchetypeRegistry
+{
+public:
+	static constexpr unsigned int type_count = sizeof...(Component);
+	static constexpr size_t chunk_bytes = 16 * 1024;
+	static constexpr size_t npos = ~size_t(0);
+
+	template <typename T>
+	static constexpr unsigned int type_id = type_index<T, Component...>::value;
+
+	template <typename... T>
+	static constexpr uint64_t signature_of()
+	{
+		return (uint64_t(0) | ... | (uint64_t(1) << type_id<T>));
+	}
+
+	// A block of memory with room for 'capacity' rows, columns are stored one after the other
+	struct Chunk
+	{
+		unsigned char* data = nullptr;
+		Entity* entities = nullptr;
+		unsigned int count = 0;
+	};
+
+	// All entities with the same component set
+	class Archetype
+	{
+	public:
+		uint64_t signature;
+		unsigned int capacity; // rows per chunk
+		size_t bytes; // chunk size, larger than chunk_bytes only if a single row does not fit
+		std::array<size_t, type_count> offsets; // column offsets within a chunk, npos if not part of the archetype
+		std::vector<Chunk> chunks;
+		size_t count = 0;
+		std::array<Archetype*, type_count> with{}; // cached archetype with one more component type
+		std::array<Archetype*, type_count> without{}; // cached archetype with one component type less
+
+		Archetype(uint64_t signature, const std::array<ArchetypeColumnType, type_count>& types)
+			: signature(signature)
+		{
+			offsets.fill(npos);
+			// Find the largest capacity whose aligned columns fit into a chunk
+			size_t row_bytes = sizeof(Entity);
+			for (unsigned int t = 0; t < type_count; t++)
+				if ((signature >> t & 1) && !types[t].empty)
+					row_bytes += types[t].size + types[t].align;
+			capacity = (unsigned int)std::max<size_t>(1, chunk_bytes / row_bytes);
+			bytes = std::max(chunk_bytes, row_bytes);
+			size_t offset = sizeof(Entity) * capacity;
+			for (unsigned int t = 0; t < type_count; t++)
+			{
+				if (!(signature >> t & 1) || types[t].empty)
+					continue;
+				offset = (offset + types[t].align - 1) / types[t].align * types[t].align;
+				offsets[t] = offset;
+				offset += types[t].size * capacity;
+			}
+			assert(offset <= bytes);
+		}
+
+		void* column(const Chunk& chunk, unsigned int type, unsigned int row, size_t size)
+		{
+			return chunk.data + offsets[type] + row * size;
+		}
+	};
+
+private:
+	std::array<ArchetypeColumnType, type_count> types = { { archetype_column_type<Component>()... } };
+	std::vector<std::unique_ptr<Archetype>> archetypes;
+
+	// Where the components of every entity index are
+	struct Location
+	{
+		Archetype* archetype = nullptr;
+		size_t row = 0;
+	};
+	std::vector<Location> locations;
+
+	Archetype* find_or_create(uint64_t signature)
+	{
+		for (std::unique_ptr<Archetype>& archetype : archetypes)
+			if (archetype->signature == signature)
+				return archetype.get();
+		archetypes.emplace_back(new Archetype(signature, types));
+		return archetypes.back().get();
+	}
+
+	Chunk& chunk_of(Archetype& archetype, size_t row)
+	{
+		return archetype.chunks[row / archetype.capacity];
+	}
+
+	void* column(Archetype& archetype, unsigned int type, size_t row)
+	{
+		Chunk& chunk = chunk_of(archetype, row);
+		return archetype.column(chunk, type, (unsigned int)(row % archetype.capacity), types[type].size);
+	}
+
+	// Append an uninitialized row for e
+	size_t push_row(Archetype& archetype, Entity e)
+	{
+		if (archetype.count == archetype.chunks.size() * archetype.capacity)
+		{
+			Chunk chunk;
+			chunk.data = static_cast<unsigned char*>(::operator new(archetype.bytes, std::align_val_t(64)));
+			chunk.entities = reinterpret_cast<Entity*>(chunk.data);
+			archetype.chunks.push_back(chunk);
+		}
+		size_t row = archetype.count++;
+		Chunk& chunk = chunk_of(archetype, row);
+		new (&chunk.entities[chunk.count++]) Entity(e);
+		return row;
+	}
+
+	// Destroy a row whose components were moved out or are no longer needed, the last row fills the hole
+	void erase_row(Archetype& archetype, size_t row)
+	{
+		size_t last = archetype.count - 1;
+		for (unsigned int t = 0; t < type_count; t++)
+		{
+			if (archetype.offsets[t] == npos)
+				continue;
+			types[t].destroy(column(archetype, t, row));
+			if (row != last)
+			{
+				types[t].move_construct(column(archetype, t, row), column(archetype, t, last));
+				types[t].destroy(column(archetype, t, last));
+			}
+		}
+		Chunk& last_chunk = chunk_of(archetype, last);
+		Entity moved = last_chunk.entities[last % archetype.capacity];
+		chunk_of(archetype, row).entities[row % archetype.capacity] = moved;
+		locations[moved.index()].row = row;
+		last_chunk.count--;
+		archetype.count--;
+		if (last_chunk.count == 0 && archetype.chunks.size() > 1)
+		{
+			::operator delete(last_chunk.data, std::align_val_t(64));
+			archetype.chunks.pop_back();
+		}
+	}
+
+	// Move e and the components it keeps into another archetype
+	void move_entity(Entity e, Archetype& target)
+	{
+		Location& location = locations[e.index()];
+		size_t row = push_row(target, e);
+		if (location.archetype)
+		{
+			Archetype& source = *location.archetype;
+			for (unsigned int t = 0; t < type_count; t++)
+				if (source.offsets[t] != npos && target.offsets[t] != npos)
+					types[t].move_construct(column(target, t, row), column(source, t, location.row));
+			// erase_row destroys the moved-from components and the ones e loses
+			erase_row(source, location.row);
+		}
+		location.archetype = &target;
+		location.row = row;
+	}
+
+	Location* find(Entity e)
+	{
+		unsigned int index = e.index();
+		if (index >= locations.size() || !locations[index].archetype || !Entity::is_alive(e))
+			return nullptr;
+		return &locations[index];
+	}
+
+public:
+	ArchetypeRegistry() {}
+	ArchetypeRegistry(const ArchetypeRegistry&) = delete;
+	ArchetypeRegistry& operator=(const ArchetypeRegistry&) = delete;
+
+	~ArchetypeRegistry()
+	{
+		clear_all_components();
+	}
+
+	template <typename T>
+	bool has(Entity e)
+	{
+		Location* location = find(e);
+		return location && (location->archetype->signature >> type_id<T> & 1);
+	}
+
+	template <typename T>
+	T& get(Entity e)
+	{
+		assert(has<T>(e) && "Entity not contained in ECS registry");
+		if constexpr (std::is_empty<T>::value)
+		{
+			static T instance;
+			return instance;
+		}
+		else
+		{
+			Location& location = locations[e.index()];
+			return *static_cast<T*>(column(*location.archetype, type_id<T>, location.row));
+		}
+	}
+
+	template <typename T>
+	T& insert(Entity e, T c)
+	{
+		assert(!has<T>(e) && "Entity already contained in ECS registry");
+		assert(Entity::is_alive(e) && "Entity was already destroyed");
+		if (e.index() >= locations.size())
+			locations.resize(e.index() + 1);
+		Location& location = locations[e.index()];
+		Archetype* source = location.archetype;
+		Archetype*& edge = source ? source->with[type_id<T>] : empty_with[type_id<T>];
+		if (!edge)
+			edge = find_or_create((source ? source->signature : 0) | signature_of<T>());
+		move_entity(e, *edge);
+		if constexpr (!std::is_empty<T>::value)
+			new (column(*location.archetype, type_id<T>, location.row)) T(std::move(c));
+		return get<T>(e);
+	}
+
+	template <typename T>
+	void remove(Entity e)
+	{
+		if (!has<T>(e))
+			return;
+		Location& location = locations[e.index()];
+		Archetype* source = location.archetype;
+		uint64_t signature = source->signature & ~signature_of<T>();
+		if (signature == 0)
+		{
+			remove_all_components_of(e);
+			return;
+		}
+		Archetype*& edge = source->without[type_id<T>];
+		if (!edge)
+			edge = find_or_create(signature);
+		move_entity(e, *edge);
+	}
+
+	void remove_all_components_of(Entity e)
+	{
+		Location* location = find(e);
+		if (!location)
+			return;
+		erase_row(*location->archetype, location->row);
+		location->archetype = nullptr;
+	}
+
+	void clear_all_components()
+	{
+		for (std::unique_ptr<Archetype>& archetype : archetypes)
+		{
+			while (archetype->count > 0)
+			{
+				Entity e = chunk_of(*archetype, archetype->count - 1).entities[(archetype->count - 1) % archetype->capacity];
+				erase_row(*archetype, archetype->count - 1);
+				locations[e.index()].archetype = nullptr;
+			}
+			for (Chunk& chunk : archetype->chunks)
+				::operator delete(chunk.data, std::align_val_t(64));
+			archetype->chunks.clear();
+		}
+	}
+
+	// Remove all entities of a scope, see ComponentRegistry::destroy_scope
+	// Rows are visited back to front, so the row that fills a hole has already been checked.
+	void destroy_scope(unsigned char scope)
+	{
+		for (std::unique_ptr<Archetype>& archetype : archetypes)
+		{
+			for (size_t row = archetype->count; row-- > 0;)
+			{
+				Entity e = chunk_of(*archetype, row).entities[row % archetype->capacity];
+				if (Entity::scope_of(e) != scope)
+					continue;
+				erase_row(*archetype, row);
+				locations[e.index()].archetype = nullptr;
+			}
+		}
+		Entity::release_scope(scope);
+	}
+
+	// The number of entities that have a component of type T
+	template <typename T>
+	size_t size()
+	{
+		size_t count = 0;
+		for (std::unique_ptr<Archetype>& archetype : archetypes)
+			if (archetype->signature >> type_id<T> & 1)
+				count += archetype->count;
+		return count;
+	}
+
+	// Calls fn(Entity, T&...) for every entity that has all of the components, chunk by chunk
+	template <typename... T, typename Function>
+	void each(Function fn)
+	{
+		constexpr uint64_t include = signature_of<T...>();
+		for (std::unique_ptr<Archetype>& archetype : archetypes)
+		{
+			if ((archetype->signature & include) != include)
+				continue;
+			for (Chunk& chunk : archetype->chunks)
+				each_in_chunk<T...>(*archetype, chunk, fn);
+		}
+	}
+
+	// The ComponentContainer-like interface of one component type
+	template <typename T>
+	class Container;
+	template <typename T>
+	Container<T> get()
+	{
+		return Container<T>(*this);
+	}
+
+private:
+	std::array<Archetype*, type_count> empty_with{}; // the archetypes with a single component
+
+	template <typename... T, typename Function>
+	void each_in_chunk(Archetype& archetype, Chunk& chunk, Function& fn)
+	{
+		std::tuple<T*...> columns(column_pointer<T>(archetype, chunk)...);
+		for (unsigned int row = 0; row < chunk.count; row++)
+			fn(chunk.entities[row], column_element<T>(std::get<T*>(columns), row)...);
+	}
+
+	template <typename T>
+	T* column_pointer(Archetype& archetype, Chunk& chunk)
+	{
+		if constexpr (std::is_empty<T>::value)
+			return nullptr;
+		else
+			return reinterpret_cast<T*>(chunk.data + archetype.offsets[type_id<T>]);
+	}
+
+	template <typename T>
+	static T& column_element(T* column, unsigned int row)
+	{
+		if constexpr (std::is_empty<T>::value)
+		{
+			static T instance;
+			return instance;
+		}
+		else
+			return column[row];
+	}
+};
+
+// Facade with the per-type API of ComponentContainer, so code can switch between the backends
+template <typename... Component>
+template <typename T>
+class ArchetypeRegistry<Component...>::Container
+{
+	ArchetypeRegistry& registry;
+public:
+	Container(ArchetypeRegistry& registry) : registry(registry) {}
+
+	T& insert(Entity e, T c) { return registry.template insert<T>(e, std::move(c)); }
+	template <typename... Args>
+	T& emplace(Entity e, Args&&... args) { return insert(e, T(std::forward<Args>(args)...)); }
+	T& get(Entity e) { return registry.template get<T>(e); }
+	T* try_get(Entity e) { return has(e) ? &get(e) : nullptr; }
+	bool has(Entity e) { return registry.template has<T>(e); }
+	void remove(Entity e) { registry.template remove<T>(e); }
+	size_t size() { return registry.template size<T>(); }
+};
@@ -4,128 +4,68 @@
 #include "tiny_ecs.hpp"
 #include "components.hpp"
 
-class ECSRegistry
-{
-	// Callbacks to remove a particular or all entities in the system
-	std::vector<ContainerInterface *> registry_list;
+// Motions are referenced while further entities are created, e.g. in the debug lines of the physics
+// step and in the createX functions, so they get addresses that survive inserts
+template <>
+struct stable_addresses<Motion> : std::true_type {};
 
+// The registry is built from the list of all components this game has
+// TODO: A1 add a LightUp component
+class ECSRegistry : public ComponentRegistry<
+	DeathTimer, Motion, Collision, Player, Mesh *, RenderRequest, ScreenState, Eatable, Deadly,
+	NormalZombie, Platform, DebugComponent, vec3, Sliding, Gravity, ColorChange, DeductHpTimer, Door,
+	Key, Bullet, Food, Character, Heart, Cabinet, SmallBullet, ShootBullet, Text, MenuElement,
+	NonPlayerCharacter, Speech, Timer, SpeechPoint, Gold, Fireball, Spikeball, InvincibleTimer,
+	SmallKey, LinearMovement, TextBlock, PlatformTile>
+{
 public:
-	// Manually created list of all components this game has
-	// TODO: A1 add a LightUp component
-	ComponentContainer<DeathTimer> deathTimers;
-	ComponentContainer<Motion> motions;
-	ComponentContainer<Collision> collisions;
-	ComponentContainer<Player> players;
-	ComponentContainer<Mesh *> meshPtrs;
-	ComponentContainer<RenderRequest> renderRequests;
-	ComponentContainer<ScreenState> screenStates;
-	ComponentContainer<Eatable> eatables;
-	ComponentContainer<Deadly> deadlys;
-	ComponentContainer<NormalZombie> zombies;
-	ComponentContainer<Platform> platforms;
-	ComponentContainer<DebugComponent> debugComponents;
-	ComponentContainer<vec3> colors;
-	ComponentContainer<Sliding> slidings;
-	ComponentContainer<Gravity> gravities;
-	ComponentContainer<ColorChange> colorChanges;
-	ComponentContainer<DeductHpTimer> deductHpTimers;
-	ComponentContainer<Door> doors;
-	ComponentContainer<Key> keys;
-	ComponentContainer<Bullet> bullets;
-	ComponentContainer<Food> foods;
-	ComponentContainer<Character> characters;
-	ComponentContainer<Heart> hearts;
-	ComponentContainer<Cabinet> cabinets;
-	ComponentContainer<SmallBullet> smallBullets;
-	ComponentContainer<ShootBullet> shootBullets;
-	ComponentContainer<Text> texts;
-	ComponentContainer<MenuElement> menus;
-	ComponentContainer<NonPlayerCharacter> nonPlayerCharacter;
-	ComponentContainer<Speech> speech;
-	ComponentContainer<Timer> timer;
-	ComponentContainer<SpeechPoint> speechPoint;
-	ComponentContainer<Gold> golds;
-	ComponentContainer<Fireball> fireballs;
-	ComponentContainer<Spikeball> spikeballs;
-	ComponentContainer<InvincibleTimer> invincibleTimers;
-	ComponentContainer<SmallKey> smallKeys;
-	ComponentContainer<LinearMovement> linearMovements;
-	ComponentContainer<TextBlock> textBlocks;
-
-
-	// constructor that adds all containers for looping over them
-	// IMPORTANT: Don't forget to add any newly added containers!
-	ECSRegistry()
-	{
-		// TODO: A1 add a LightUp component
-		registry_list.push_back(&deathTimers);
-		registry_list.push_back(&motions);
-		registry_list.push_back(&collisions);
-		registry_list.push_back(&players);
-		registry_list.push_back(&meshPtrs);
-		registry_list.push_back(&renderRequests);
-		registry_list.push_back(&screenStates);
-		registry_list.push_back(&eatables);
-		registry_list.push_back(&deadlys);
-		registry_list.push_back(&zombies);
-		registry_list.push_back(&platforms);
-		registry_list.push_back(&debugComponents);
-		registry_list.push_back(&colors);
-		registry_list.push_back(&slidings);
-		registry_list.push_back(&gravities);
-		registry_list.push_back(&colorChanges);
-		registry_list.push_back(&deductHpTimers);
-		registry_list.push_back(&doors);
-		registry_list.push_back(&keys);
-		registry_list.push_back(&bullets);
-		registry_list.push_back(&foods);
-		registry_list.push_back(&characters);
-		registry_list.push_back(&hearts);
-		registry_list.push_back(&cabinets);
-		registry_list.push_back(&smallBullets);
-		registry_list.push_back(&shootBullets);
-		registry_list.push_back(&texts);
-		registry_list.push_back(&menus);
-		registry_list.push_back(&nonPlayerCharacter);
-		registry_list.push_back(&speech);
-		registry_list.push_back(&timer);
-		registry_list.push_back(&speechPoint);
-		registry_list.push_back(&golds);
-		registry_list.push_back(&fireballs);
-		registry_list.push_back(&spikeballs);
-		registry_list.push_back(&invincibleTimers);
-		registry_list.push_back(&smallKeys);
-		registry_list.push_back(&linearMovements);
-		registry_list.push_back(&textBlocks);
-	}
-
-	void clear_all_components()
-	{
-		for (ContainerInterface *reg : registry_list)
-			reg->clear();
-	}
-
-	void list_all_components()
-	{
-		printf("Debug info on all registry entries:\n");
-		for (ContainerInterface *reg : registry_list)
-			if (reg->size() > 0)
-				printf("%4d components of type %s\n", (int)reg->size(), typeid(*reg).name());
-	}
-
-	void list_all_components_of(Entity e)
-	{
-		printf("Debug info on components of entity %u:\n", (unsigned int)e);
-		for (ContainerInterface *reg : registry_list)
-			if (reg->has(e))
-				printf("type %s\n", typeid(*reg).name());
-	}
+	// Named access to the containers
+	ComponentContainer<DeathTimer>& deathTimers = get<DeathTimer>();
+	ComponentContainer<Motion>& motions = get<Motion>();
+	ComponentContainer<Collision>& collisions = get<Collision>();
+	ComponentContainer<Player>& players = get<Player>();
+	ComponentContainer<Mesh *>& meshPtrs = get<Mesh *>();
+	ComponentContainer<RenderRequest>& renderRequests = get<RenderRequest>();
+	ComponentContainer<ScreenState>& screenStates = get<ScreenState>();
+	TagContainer<Eatable>& eatables = get<Eatable>();
+	TagContainer<Deadly>& deadlys = get<Deadly>();
+	ComponentContainer<NormalZombie>& zombies = get<NormalZombie>();
+	ComponentContainer<Platform>& platforms = get<Platform>();
+	TagContainer<DebugComponent>& debugComponents = get<DebugComponent>();
+	ComponentContainer<vec3>& colors = get<vec3>();
+	ComponentContainer<Sliding>& slidings = get<Sliding>();
+	TagContainer<Gravity>& gravities = get<Gravity>();
+	ComponentContainer<ColorChange>& colorChanges = get<ColorChange>();
+	ComponentContainer<DeductHpTimer>& deductHpTimers = get<DeductHpTimer>();
+	ComponentContainer<Door>& doors = get<Door>();
+	TagContainer<Key>& keys = get<Key>();
+	TagContainer<Bullet>& bullets = get<Bullet>();
+	TagContainer<Food>& foods = get<Food>();
+	ComponentContainer<Character>& characters = get<Character>();
+	TagContainer<Heart>& hearts = get<Heart>();
+	TagContainer<Cabinet>& cabinets = get<Cabinet>();
+	TagContainer<SmallBullet>& smallBullets = get<SmallBullet>();
+	TagContainer<ShootBullet>& shootBullets = get<ShootBullet>();
+	ComponentContainer<Text>& texts = get<Text>();
+	ComponentContainer<MenuElement>& menus = get<MenuElement>();
+	ComponentContainer<NonPlayerCharacter>& nonPlayerCharacter = get<NonPlayerCharacter>();
+	ComponentContainer<Speech>& speech = get<Speech>();
+	ComponentContainer<Timer>& timer = get<Timer>();
+	ComponentContainer<SpeechPoint>& speechPoint = get<SpeechPoint>();
+	TagContainer<Gold>& golds = get<Gold>();
+	TagContainer<Fireball>& fireballs = get<Fireball>();
+	ComponentContainer<Spikeball>& spikeballs = get<Spikeball>();
+	ComponentContainer<InvincibleTimer>& invincibleTimers = get<InvincibleTimer>();
+	TagContainer<SmallKey>& smallKeys = get<SmallKey>();
+	ComponentContainer<LinearMovement>& linearMovements = get<LinearMovement>();
+	ComponentContainer<TextBlock>& textBlocks = get<TextBlock>();
+	TagContainer<PlatformTile>& platformTiles = get<PlatformTile>();
 
-	void remove_all_components_of(Entity e)
-	{
-		for (ContainerInterface *reg : registry_list)
-			reg->remove(e);
-	}
+	// Owning groups that keep platforms and zombies in lockstep with their motions.
+	// Platforms occupy the front of motions and the zombies follow right behind them.
+	// Note, Motion and RenderRequest are deliberately not grouped, the render order is the order of renderRequests.
+	OwningGroup<Motion, Platform> platformGroup{ motions, platforms };
+	OwningGroup<Motion, NormalZombie> zombieGroup{ motions, zombies };
 };
 
 extern ECSRegistry registry;
\ No newline at end of file
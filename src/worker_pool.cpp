@@ -0,0 +1,87 @@
+// internal
+#include "worker_pool.hpp"
+
+// stlib
+#include <algorithm>
+
+WorkerPool::WorkerPool(unsigned int workers)
+{
+	for (unsigned int i = 0; i < workers; i++)
+		threads.emplace_back([this]() { work(); });
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (std::thread& thread : threads)
+		thread.join();
+}
+
+WorkerPool& WorkerPool::shared()
+{
+	static WorkerPool pool(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+	return pool;
+}
+
+void WorkerPool::run_ranges(Job& job)
+{
+	for (size_t begin = job.next.fetch_add(job.range); begin < job.count; begin = job.next.fetch_add(job.range))
+		job.call(job.fn, begin, std::min(begin + job.range, job.count));
+}
+
+void WorkerPool::work()
+{
+	unsigned int seen = 0;
+	while (true)
+	{
+		Job* current;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&]() { return stopping || generation != seen; });
+			if (stopping)
+				return;
+			seen = generation;
+			// The job may already be over if this worker woke up late
+			current = job;
+			if (!current)
+				continue;
+			busy++;
+		}
+		run_ranges(*current);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			busy--;
+		}
+		done.notify_one();
+	}
+}
+
+void WorkerPool::run(Job& current)
+{
+	current.range = std::max<size_t>(current.range, 1);
+
+	// A single range isn't worth waking the workers, and a nested loop runs on the calling thread
+	std::unique_lock<std::mutex> lock(mutex);
+	if (current.count <= current.range || threads.empty() || job)
+	{
+		lock.unlock();
+		run_ranges(current);
+		return;
+	}
+
+	job = &current;
+	generation++;
+	lock.unlock();
+	wake.notify_all();
+
+	run_ranges(current);
+
+	// Workers that joined may still be on their last range, the ones that didn't won't see the job anymore
+	lock.lock();
+	done.wait(lock, [&]() { return busy == 0; });
+	job = nullptr;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+// stlib
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// A fixed set of threads that run the ranges of parallel loops, see ComponentRegistry::parallel_each
+// The calling thread works on the ranges too and run() returns once all of them are done. A range is always
+// processed by a single thread, so which elements end up in the same range doesn't depend on the timing.
+class WorkerPool
+{
+	// A loop that is being run, it lives on the stack of the calling thread
+	// The callable isn't wrapped in a std::function, only a pointer to it and a function that calls it are
+	// kept, so starting a loop doesn't allocate.
+	struct Job
+	{
+		void* fn;
+		void (*call)(void* fn, size_t begin, size_t end);
+		size_t count;
+		size_t range;
+		std::atomic<size_t> next{ 0 };
+	};
+
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable wake; // a new job was posted or the pool stops
+	std::condition_variable done; // a worker left the current job
+	Job* job = nullptr;
+	unsigned int generation = 0;
+	unsigned int busy = 0; // workers that are in the current job
+	bool stopping = false;
+
+	void work();
+	static void run_ranges(Job& job);
+	void run(Job& job);
+
+public:
+	// A pool with the given number of workers besides the calling thread
+	explicit WorkerPool(unsigned int workers);
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+	~WorkerPool();
+
+	// The pool shared by the systems, with a worker per additional hardware thread, started on first use
+	static WorkerPool& shared();
+
+	// The number of threads that run a loop, including the calling one
+	unsigned int concurrency() const { return (unsigned int)threads.size() + 1; }
+
+	// Call fn(begin, end) for the ranges [0, range), [range, 2 * range), ... of [0, count)
+	// Note, only one loop runs at a time, calling run() from within fn runs the nested loop on the caller.
+	template <typename Function>
+	void run(size_t count, size_t range, Function&& fn)
+	{
+		using Callable = typename std::remove_reference<Function>::type;
+		Job job;
+		job.fn = (void*)&fn;
+		job.call = [](void* fn, size_t begin, size_t end) { (*static_cast<Callable*>(fn))(begin, end); };
+		job.count = count;
+		job.range = range;
+		run(job);
+	}
+};
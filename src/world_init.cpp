@@ -1,482 +1,230 @@
 #include "world_init.hpp"
 #include "tiny_ecs_registry.hpp"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <map>
 
-Entity createJosh(RenderSystem *renderer, vec2 position)
+// The blueprint of a textured sprite with the components 'Tag', e.g. markers like Eatable
+// The prefabs of the createX functions are built on their first call, as the mesh belongs to the renderer.
+template <typename... Tag>
+Prefab<Mesh *, Motion, Tag..., RenderRequest> spritePrefab(RenderSystem *renderer, TEXTURE_ASSET_ID texture, vec2 scale, float angle = 0.f, GEOMETRY_BUFFER_ID mesh = GEOMETRY_BUFFER_ID::SPRITE)
 {
-	auto entity = Entity();
-
-	Mesh &mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::JOSH);
-	registry.meshPtrs.emplace(entity, &mesh);
-	auto &motion = registry.motions.emplace(entity);
-
-	motion.angle = 0.f;
+	Motion motion;
+	motion.angle = angle;
 	motion.velocity = {0, 0};
-	motion.position = position;
-	motion.scale = vec2({JOSH_BB_WIDTH * 0.5, JOSH_BB_HEIGHT * 0.6});
-	registry.players.emplace(entity);
-	registry.gravities.emplace(entity);
-	registry.renderRequests.insert(
-		entity,
-		{TEXTURE_ASSET_ID::JOSHGUN1,
+	motion.scale = scale;
+	return Prefab<Mesh *, Motion, Tag..., RenderRequest>(
+		&renderer->getMesh(mesh),
+		motion,
+		Tag()...,
+		{texture,
 		 EFFECT_ASSET_ID::TEXTURED,
 		 GEOMETRY_BUFFER_ID::SPRITE});
+}
 
+// A copy of a prefab at the given position
+template <typename... Component>
+Entity spawn(const Prefab<Component...> &prefab, vec2 position)
+{
+	Entity entity = prefab.instantiate(registry);
+	registry.motions.get(entity).position = position;
 	return entity;
 }
 
-Entity createZombie(RenderSystem *renderer, vec2 position, int state, double range)
+Entity createJosh(RenderSystem *renderer, vec2 position)
 {
-	auto entity = Entity();
-
-	// Store a reference to the potentially re-used mesh object (the value is stored in the resource cache)
-	Mesh &mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
-	registry.meshPtrs.emplace(entity, &mesh);
-
-	// Initialize the motion of zombie to rightwards
-	auto &motion = registry.motions.emplace(entity);
-	motion.angle = 0.f;
-	motion.velocity = {0, 0};
-	motion.position = position;
+	static const auto josh = spritePrefab<Player, Gravity>(renderer, TEXTURE_ASSET_ID::JOSHGUN1,
+		vec2({JOSH_BB_WIDTH * 0.5, JOSH_BB_HEIGHT * 0.6}), 0.f, GEOMETRY_BUFFER_ID::JOSH);
+	return spawn(josh, position);
+}
 
-	// Setting initial values, scale is negative to make it face the opposite way
-	motion.scale = vec2({ZOMBIE_BB_WIDTH * 0.6, ZOMBIE_BB_HEIGHT * 0.6});
+Entity createZombie(RenderSystem *renderer, vec2 position, int state, double range)
+{
+	static const auto zombie = spritePrefab<Deadly, NormalZombie, Gravity>(renderer, TEXTURE_ASSET_ID::ZOMBIE,
+		vec2({ZOMBIE_BB_WIDTH * 0.6, ZOMBIE_BB_HEIGHT * 0.6}));
+	Entity entity = spawn(zombie, position);
 
-	// Create and (empty) Eagle component to be able to refer to all eagles
-	registry.deadlys.emplace(entity);
-	registry.zombies.emplace(entity);
-	registry.gravities.emplace(entity);
+	// The zombie walks around its initial position
 	registry.zombies.get(entity).walking_bound[0] = position.x - range;
 	registry.zombies.get(entity).walking_bound[1] = position.x + range;
-	registry.renderRequests.insert(
-		entity,
-		{TEXTURE_ASSET_ID::ZOMBIE,
-		 EFFECT_ASSET_ID::TEXTURED,
-		 GEOMETRY_BUFFER_ID::SPRITE});
-
 	return entity;
 }
 
 Entity createFood(RenderSystem *renderer, vec2 position)
 {
-	// Reserve en entity
-	auto entity = Entity();
-
-	// Store a reference to the potentially re-used mesh object
-	Mesh &mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
-	registry.meshPtrs.emplace(entity, &mesh);
-
-	// Initialize the position, scale, and physics components
-	auto &motion = registry.motions.emplace(entity);
-	motion.angle = 0.f;
-	motion.velocity = {0, 0};
-	motion.position = position;
-
-	// Setting initial values, scale is negative to make it face the opposite way
-	motion.scale = vec2({-FOOD_BB_WIDTH, FOOD_BB_HEIGHT});
-
-	// Create an (empty) Bug component to be able to refer to all bug
-	registry.eatables.emplace(entity);
-	registry.foods.emplace(entity);
-	registry.renderRequests.insert(
-		entity,
-		{TEXTURE_ASSET_ID::FOOD,
-		 EFFECT_ASSET_ID::TEXTURED,
-		 GEOMETRY_BUFFER_ID::SPRITE});
-
-	return entity;
+	static const auto food = spritePrefab<Eatable, Food>(renderer, TEXTURE_ASSET_ID::FOOD, vec2({-FOOD_BB_WIDTH, FOOD_BB_HEIGHT}));
+	return spawn(food, position);
 }
 
 Entity createBullet(RenderSystem *renderer, vec2 position)
 {
-	// Reserve en entity
-	auto entity = Entity();
-
-	// Store a reference to the potentially re-used mesh object
-	Mesh &mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
-	registry.meshPtrs.emplace(entity, &mesh);
-
-	// Initialize the position, scale, and physics components
-	auto &motion = registry.motions.emplace(entity);
-	motion.angle = 0.f;
-	motion.velocity = {0, 0};
-	motion.position = position;
-
-	// Setting initial values, scale is negative to make it face the opposite way
-	motion.scale = vec2({-HEART_BB_WIDTH, HEART_BB_HEIGHT});
-
-	// Create an (empty) Bug component to be able to refer to all bug
-	registry.eatables.emplace(entity);
-	registry.bullets.emplace(entity);
-	registry.renderRequests.insert(
-		entity,
-		{TEXTURE_ASSET_ID::BULLET,
-		 EFFECT_ASSET_ID::TEXTURED,
-		 GEOMETRY_BUFFER_ID::SPRITE});
-
-	return entity;
+	static const auto bullet = spritePrefab<Eatable, Bullet>(renderer, TEXTURE_ASSET_ID::BULLET, vec2({-HEART_BB_WIDTH, HEART_BB_HEIGHT}));
+	return spawn(bullet, position);
 }
 
 Entity createBulletShoot(RenderSystem *renderer, vec2 position)
 {
-	// Reserve en entity
-	auto entity = Entity();
-
-	// Store a reference to the potentially re-used mesh object
-	Mesh &mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
-	registry.meshPtrs.emplace(entity, &mesh);
-
-	// Initialize the position, scale, and physics components
-	auto &motion = registry.motions.emplace(entity);
-	motion.angle = 0.f;
-	motion.velocity = {0, 0};
-	motion.position = position;
-
-	// Setting initial values, scale is negative to make it face the opposite way
-	motion.scale = vec2({-HEART_BB_WIDTH, HEART_BB_HEIGHT});
-
-	// Create an (empty) Bug component to be able to refer to all bug
-	registry.shootBullets.emplace(entity);
-	registry.renderRequests.insert(
-		entity,
-		{TEXTURE_ASSET_ID::BULLET,
-		 EFFECT_ASSET_ID::TEXTURED,
-		 GEOMETRY_BUFFER_ID::SPRITE});
-
-	return entity;
+	static const auto bullet = spritePrefab<ShootBullet>(renderer, TEXTURE_ASSET_ID::BULLET, vec2({-HEART_BB_WIDTH, HEART_BB_HEIGHT}));
+	return spawn(bullet, position);
 }
 
 Entity createBulletSmall(RenderSystem *renderer, vec2 position)
 {
-	// Reserve en entity
-	auto entity = Entity();
-
-	// Store a reference to the potentially re-used mesh object
-	Mesh &mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
-	registry.meshPtrs.emplace(entity, &mesh);
-
-	// Initialize the position, scale, and physics components
-	auto &motion = registry.motions.emplace(entity);
-	motion.angle = 2.4f;
-	motion.velocity = {0, 0};
-	motion.position = position;
-
-	// Setting initial values, scale is negative to make it face the opposite way
-	motion.scale = vec2({-SMALL_BULLET_BB_WIDTH, SMALL_BULLET_BB_HEIGHT});
-
-	// Create an (empty) Bug component to be able to refer to all bug
-	registry.smallBullets.emplace(entity);
-	registry.renderRequests.insert(
-		entity,
-		{TEXTURE_ASSET_ID::BULLET,
-		 EFFECT_ASSET_ID::TEXTURED,
-		 GEOMETRY_BUFFER_ID::SPRITE});
-
-	return entity;
+	static const auto bullet = spritePrefab<SmallBullet>(renderer, TEXTURE_ASSET_ID::BULLET, vec2({-SMALL_BULLET_BB_WIDTH, SMALL_BULLET_BB_HEIGHT}), 2.4f);
+	return spawn(bullet, position);
 }
 
 Entity createKey(RenderSystem *renderer, vec2 position)
 {
-	// Reserve en entity
-	auto entity = Entity();
-
-	// Store a reference to the potentially re-used mesh object
-	Mesh &mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
-	registry.meshPtrs.emplace(entity, &mesh);
-
-	// Initialize the position, scale, and physics components
-	auto &motion = registry.motions.emplace(entity);
-	motion.angle = 0.f;
-	motion.velocity = {0, 0};
-	motion.position = position;
-
-	// Setting initial values, scale is negative to make it face the opposite way
-	motion.scale = vec2({-HEART_BB_WIDTH, HEART_BB_HEIGHT});
-
-	// Create an (empty) Bug component to be able to refer to all bug
-	registry.eatables.emplace(entity);
-	registry.keys.emplace(entity);
-	registry.renderRequests.insert(
-		entity,
-		{TEXTURE_ASSET_ID::KEY,
-		 EFFECT_ASSET_ID::TEXTURED,
-		 GEOMETRY_BUFFER_ID::SPRITE});
-
-	return entity;
+	static const auto key = spritePrefab<Eatable, Key>(renderer, TEXTURE_ASSET_ID::KEY, vec2({-HEART_BB_WIDTH, HEART_BB_HEIGHT}));
+	return spawn(key, position);
 }
 
 Entity createSmallKey(RenderSystem *renderer, vec2 position)
 {
-	// Reserve en entity
-	auto entity = Entity();
-
-	// Store a reference to the potentially re-used mesh object
-	Mesh &mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
-	registry.meshPtrs.emplace(entity, &mesh);
-
-	// Initialize the position, scale, and physics components
-	auto &motion = registry.motions.emplace(entity);
-	motion.angle = 0.8f;
-	motion.velocity = {0, 0};
-	motion.position = position;
-
-	// Setting initial values, scale is negative to make it face the opposite way
-	motion.scale = vec2({-KEY_BB_WIDTH, KEY_BB_HEIGHT});
-
-	// Create an (empty) Bug component to be able to refer to all bug
-	// registry.eatables.emplace(entity);
-	 registry.smallKeys.emplace(entity);
-	registry.renderRequests.insert(
-		entity,
-		{TEXTURE_ASSET_ID::KEY,
-		 EFFECT_ASSET_ID::TEXTURED,
-		 GEOMETRY_BUFFER_ID::SPRITE});
-
-	return entity;
+	static const auto key = spritePrefab<SmallKey>(renderer, TEXTURE_ASSET_ID::KEY, vec2({-KEY_BB_WIDTH, KEY_BB_HEIGHT}), 0.8f);
+	return spawn(key, position);
 }
 
 Entity createDoor(RenderSystem *renderer, vec2 position)
 {
-	// Reserve en entity
-	auto entity = Entity();
-
-	// Store a reference to the potentially re-used mesh object
-	Mesh &mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
-	registry.meshPtrs.emplace(entity, &mesh);
-
-	// Initialize the position, scale, and physics components
-	auto &motion = registry.motions.emplace(entity);
-	motion.angle = 0.f;
-	motion.velocity = {0, 0};
-	motion.position = position;
-
-	// Setting initial values, scale is negative to make it face the opposite way
-	motion.scale = vec2({-DOOR_BB_WIDTH, DOOR_BB_HEIGHT});
-
-	// Create an (empty) Bug component to be able to refer to all bug
-	registry.doors.emplace(entity);
-	registry.renderRequests.insert(
-		entity,
-		{TEXTURE_ASSET_ID::DOOR,
-		 EFFECT_ASSET_ID::TEXTURED,
-		 GEOMETRY_BUFFER_ID::SPRITE});
-
-	return entity;
+	static const auto door = spritePrefab<Door>(renderer, TEXTURE_ASSET_ID::DOOR, vec2({-DOOR_BB_WIDTH, DOOR_BB_HEIGHT}));
+	return spawn(door, position);
 }
 
 Entity createCabinet(RenderSystem *renderer, vec2 position)
 {
-	// Reserve en entity
-	auto entity = Entity();
-
-	// Store a reference to the potentially re-used mesh object
-	Mesh &mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
-	registry.meshPtrs.emplace(entity, &mesh);
-
-	// Initialize the position, scale, and physics components
-	auto &motion = registry.motions.emplace(entity);
-	motion.angle = 0.f;
-	motion.velocity = {0, 0};
-	motion.position = position;
-
-	// Setting initial values, scale is negative to make it face the opposite way
-	motion.scale = vec2({-CABINET_BB_WIDTH, CABINET_BB_HEIGHT});
-
-	// Create an (empty) Bug component to be able to refer to all bug
-	registry.cabinets.emplace(entity);
-	registry.renderRequests.insert(
-		entity,
-		{TEXTURE_ASSET_ID::CABINET,
-		 EFFECT_ASSET_ID::TEXTURED,
-		 GEOMETRY_BUFFER_ID::SPRITE});
-
-	return entity;
+	static const auto cabinet = spritePrefab<Cabinet>(renderer, TEXTURE_ASSET_ID::CABINET, vec2({-CABINET_BB_WIDTH, CABINET_BB_HEIGHT}));
+	return spawn(cabinet, position);
 }
 
-Entity createPlatform(RenderSystem *renderer, vec2 pos)
+// The colliders of the platform tiles, merged into as few boxes as possible
+// The colliders of tiles up to max_step cells apart overlap, so a run of such tiles covers the same area as
+// one box from its first to its last collider. Runs are merged first along the rows and then with the runs
+// of the same columns in the rows below, which turns walls and thick floors into single boxes.
+static std::vector<Platform> mergePlatformTiles(const std::vector<std::pair<vec2, TEXTURE_ASSET_ID>> &tiles)
 {
-	auto entity = Entity();
-
-	Mesh &mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
-	registry.meshPtrs.emplace(entity, &mesh);
-
-	auto &platform = registry.platforms.emplace(entity);
-	platform.position = pos;
-	platform.scale = {PLATFORM_WIDTH, PLATFORM_HEIGHT};
-
-	auto &motion = registry.motions.emplace(entity);
-	motion.angle = 0.f;
-	motion.velocity = {0.0f, 0.0f};
-	motion.position = pos;
-	motion.scale = {PLATFORM_WIDTH, PLATFORM_HEIGHT};
-
-	// registry.platforms.emplace(entity);
-	registry.renderRequests.insert(
-		entity,
-		{TEXTURE_ASSET_ID::PLATFORM,
-		 EFFECT_ASSET_ID::TEXTURED,
-		 GEOMETRY_BUFFER_ID::SPRITE});
+	std::vector<Platform> boxes;
+	if (tiles.empty())
+		return boxes;
+	const int max_step = int(PLATFORM_WIDTH / PLATFORM_TILE_SIZE);
+
+	// The tiles on the map grid
+	int rows = 0, columns = 0;
+	for (const auto &tile : tiles)
+	{
+		rows = std::max(rows, int(std::round(tile.first.y / PLATFORM_TILE_SIZE)) + 1);
+		columns = std::max(columns, int(std::round(tile.first.x / PLATFORM_TILE_SIZE)) + 1);
+	}
+	std::vector<char> solid(size_t(rows) * columns, 0);
+	for (const auto &tile : tiles)
+		solid[size_t(std::round(tile.first.y / PLATFORM_TILE_SIZE)) * columns + size_t(std::round(tile.first.x / PLATFORM_TILE_SIZE))] = 1;
 
-	return entity;
+	// The box that ends in the row 'last' for each column range of a run, to append the runs below it
+	struct Open
+	{
+		size_t box;
+		int first_row;
+		int last_row;
+	};
+	std::map<std::pair<int, int>, Open> open;
+	for (int row = 0; row < rows; row++)
+	{
+		for (int column = 0; column < columns; column++)
+		{
+			if (!solid[size_t(row) * columns + column])
+				continue;
+			// Extend the run as long as there is another tile within max_step cells
+			int first = column;
+			for (int next = column + 1; next <= column + max_step && next < columns; next++)
+				if (solid[size_t(row) * columns + next])
+					column = next;
+
+			auto it = open.find({first, column});
+			if (it != open.end() && row - it->second.last_row <= max_step)
+			{
+				it->second.last_row = row;
+			}
+			else
+			{
+				boxes.push_back(Platform());
+				open[{first, column}] = {boxes.size() - 1, row, row};
+				it = open.find({first, column});
+			}
+			Platform &box = boxes[it->second.box];
+			box.position = vec2(first + column, it->second.first_row + row) * (PLATFORM_TILE_SIZE / 2);
+			box.scale = vec2((column - first) * PLATFORM_TILE_SIZE + PLATFORM_WIDTH, (row - it->second.first_row) * PLATFORM_TILE_SIZE + PLATFORM_HEIGHT);
+		}
+	}
+	return boxes;
 }
 
-Entity createPlatformVert(RenderSystem* renderer, vec2 pos)
+// All platform tiles of a level in one batch, the texture tells horizontal and vertical tiles apart
+// Every tile gets a sprite, the collisions are checked against the merged boxes, see mergePlatformTiles.
+void createPlatforms(RenderSystem *renderer, const std::vector<std::pair<vec2, TEXTURE_ASSET_ID>> &tiles)
 {
-	auto entity = Entity();
-
-	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
-	registry.meshPtrs.emplace(entity, &mesh);
-
-	auto& platform = registry.platforms.emplace(entity);
-	platform.position = pos;
-	platform.scale = { PLATFORM_WIDTH, PLATFORM_HEIGHT };
-
-	auto& motion = registry.motions.emplace(entity);
-	motion.angle = 0.f;
-	motion.velocity = { 0.0f, 0.0f };
-	motion.position = pos;
-	motion.scale = { PLATFORM_WIDTH, PLATFORM_HEIGHT };
-
-	// registry.platforms.emplace(entity);
-	registry.renderRequests.insert(
-		entity,
-		{ TEXTURE_ASSET_ID::GROUNDVERT,
-		 EFFECT_ASSET_ID::TEXTURED,
-		 GEOMETRY_BUFFER_ID::SPRITE });
-
-	return entity;
+	std::vector<Platform> boxes = mergePlatformTiles(tiles);
+	registry.create_many<Platform, Motion>(boxes.size(), [&](size_t i, Platform &platform, Motion &motion) {
+		platform = boxes[i];
+		motion.angle = 0.f;
+		motion.velocity = {0.0f, 0.0f};
+		motion.position = platform.position;
+		motion.scale = platform.scale;
+	});
+
+	Mesh *mesh = &renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
+	registry.create_many<Mesh *, PlatformTile, Motion, RenderRequest>(tiles.size(), [&](size_t i, Mesh *&meshPtr, PlatformTile &, Motion &motion, RenderRequest &request) {
+		vec2 pos = tiles[i].first;
+		meshPtr = mesh;
+
+		motion.angle = 0.f;
+		motion.velocity = {0.0f, 0.0f};
+		motion.position = pos;
+		motion.scale = {PLATFORM_WIDTH, PLATFORM_HEIGHT};
+
+		request = {tiles[i].second,
+			EFFECT_ASSET_ID::TEXTURED,
+			GEOMETRY_BUFFER_ID::SPRITE};
+	});
 }
 
-
 Entity createObject(RenderSystem *renderer, vec2 pos)
 {
-	auto entity = Entity();
-
-	Mesh &mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
-	registry.meshPtrs.emplace(entity, &mesh);
-
-
-	auto &motion = registry.motions.emplace(entity);
-	motion.angle = 0.f;
-	motion.velocity = {0.0f, 0.0f};
-	motion.position = pos;
-	motion.scale = vec2({HEART_BB_WIDTH, HEART_BB_HEIGHT});
-
-	// registry.platforms.emplace(entity);
-	registry.renderRequests.insert(
-		entity,
-		{TEXTURE_ASSET_ID::BARREL,
-		 EFFECT_ASSET_ID::TEXTURED,
-		 GEOMETRY_BUFFER_ID::SPRITE});
-
-	return entity;
+	static const auto barrel = spritePrefab<>(renderer, TEXTURE_ASSET_ID::BARREL, vec2({HEART_BB_WIDTH, HEART_BB_HEIGHT}));
+	return spawn(barrel, pos);
 }
 
 Entity createHeart(RenderSystem *renderer, vec2 position)
 {
-	// Reserve en entity
-	auto entity = Entity();
-
-	// Store a reference to the potentially re-used mesh object
-	Mesh &mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
-	registry.meshPtrs.emplace(entity, &mesh);
-
-	// Initialize the position, scale, and physics components
-	auto &motion = registry.motions.emplace(entity);
-	motion.angle = 0.f;
-	motion.velocity = {0, 0};
-	motion.position = position;
-
-	// Setting initial values, scale is negative to make it face the opposite way
-	motion.scale = vec2({-HEART_BB_HEIGHT, HEART_BB_WIDTH});
-
-	// Create an (empty) Bug component to be able to refer to all bug
-	registry.hearts.emplace(entity);
-	registry.renderRequests.insert(
-		entity,
-		{TEXTURE_ASSET_ID::HEART,
-		 EFFECT_ASSET_ID::TEXTURED,
-		 GEOMETRY_BUFFER_ID::SPRITE});
-
-	return entity;
+	static const auto heart = spritePrefab<Heart>(renderer, TEXTURE_ASSET_ID::HEART, vec2({-HEART_BB_HEIGHT, HEART_BB_WIDTH}));
+	return spawn(heart, position);
 }
 
 Entity createLine(vec2 position, vec2 scale)
 {
-	Entity entity = Entity();
-
-	// Store a reference to the potentially re-used mesh object (the value is stored in the resource cache)
-	registry.renderRequests.insert(
-		entity,
+	// Debug lines have no mesh
+	static const Prefab<RenderRequest, Motion, DebugComponent> line(
 		{TEXTURE_ASSET_ID::TEXTURE_COUNT,
 		 EFFECT_ASSET_ID::EGG,
-		 GEOMETRY_BUFFER_ID::DEBUG_LINE});
-
-	// Create motion
-	Motion &motion = registry.motions.emplace(entity);
-	motion.angle = 0.f;
-	motion.velocity = {0, 0};
-	motion.position = position;
-	motion.scale = scale;
-
-	registry.debugComponents.emplace(entity);
+		 GEOMETRY_BUFFER_ID::DEBUG_LINE},
+		Motion(),
+		DebugComponent());
+	Entity entity = spawn(line, position);
+	registry.motions.get(entity).scale = scale;
 	return entity;
 }
 
 Entity createHelpInfo(RenderSystem *renderer, vec2 position)
 {
-	// Reserve en entity
-	auto entity = Entity();
-
-	// Store a reference to the potentially re-used mesh object
-	Mesh &mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
-	registry.meshPtrs.emplace(entity, &mesh);
-
-	// Initialize the position, scale, and physics components
-	auto &motion = registry.motions.emplace(entity);
-	motion.angle = 0.f;
-	motion.velocity = {0, 0};
-	motion.position = position;
-
-	// Setting initial values, scale is negative to make it face the opposite way
-	motion.scale = vec2(900, 600);
-	registry.menus.emplace(entity);
-	registry.renderRequests.insert(
-		entity,
-		{TEXTURE_ASSET_ID::HELP_INFO,
-		 EFFECT_ASSET_ID::TEXTURED,
-		 GEOMETRY_BUFFER_ID::SPRITE});
-
-	registry.debugComponents.emplace(entity);
-	return entity;
+	static const auto helpInfo = spritePrefab<MenuElement, DebugComponent>(renderer, TEXTURE_ASSET_ID::HELP_INFO, vec2(900, 600));
+	return spawn(helpInfo, position);
 }
 
 Entity createHelpSign(RenderSystem *renderer, vec2 position)
 {
-	// Reserve en entity
-	auto entity = Entity();
-
-	// Store a reference to the potentially re-used mesh object
-	Mesh &mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
-	registry.meshPtrs.emplace(entity, &mesh);
-
-	// Initialize the position, scale, and physics components
-	auto &motion = registry.motions.emplace(entity);
-	motion.angle = 0.f;
-	motion.velocity = {0, 0};
-	motion.position = position;
-
-	// Setting initial values, scale is negative to make it face the opposite way
-	motion.scale = vec2(90, 85);
-
-	registry.eatables.emplace(entity);
-	registry.renderRequests.insert(
-		entity,
-		{TEXTURE_ASSET_ID::HELP_SIGN,
-		 EFFECT_ASSET_ID::TEXTURED,
-		 GEOMETRY_BUFFER_ID::SPRITE});
-
-	return entity;
+	static const auto helpSign = spritePrefab<Eatable>(renderer, TEXTURE_ASSET_ID::HELP_SIGN, vec2(90, 85));
+	return spawn(helpSign, position);
 }
 
 
@@ -775,125 +523,26 @@ Entity createTextBlock(vec2 pos, vec2 scale, std::string content)
 
 Entity createGold(RenderSystem *renderer, vec2 position)
 {
-	// Reserve en entity
-	auto entity = Entity();
-
-	// Store a reference to the potentially re-used mesh object
-	Mesh &mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
-	registry.meshPtrs.emplace(entity, &mesh);
-
-	// Initialize the position, scale, and physics components
-	auto &motion = registry.motions.emplace(entity);
-	motion.angle = 0.f;
-	motion.velocity = {0, 0};
-	motion.position = position;
-
-	// Setting initial values, scale is negative to make it face the opposite way
-	motion.scale = vec2({-FOOD_BB_WIDTH, FOOD_BB_HEIGHT});
-
-	// Create an (empty) Bug component to be able to refer to all bug
-	registry.eatables.emplace(entity);
-	registry.golds.emplace(entity);
-	registry.renderRequests.insert(
-		entity,
-		{TEXTURE_ASSET_ID::GOLD1,
-		 EFFECT_ASSET_ID::TEXTURED,
-		 GEOMETRY_BUFFER_ID::SPRITE});
-
-	return entity;
+	static const auto gold = spritePrefab<Eatable, Gold>(renderer, TEXTURE_ASSET_ID::GOLD1, vec2({-FOOD_BB_WIDTH, FOOD_BB_HEIGHT}));
+	return spawn(gold, position);
 }
 
 
 Entity createFireball(RenderSystem* renderer, vec2 position)
 {
-	// Reserve en entity
-	auto entity = Entity();
-
-	// Store a reference to the potentially re-used mesh object
-	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
-	registry.meshPtrs.emplace(entity, &mesh);
-
-	// Initialize the position, scale, and physics components
-	auto& motion = registry.motions.emplace(entity);
-	motion.angle = 0.f;
-	motion.velocity = { 0, 0 };
-	motion.position = position;
-
-	// Setting initial values, scale is negative to make it face the opposite way
-	motion.scale = vec2({ -FOOD_BB_WIDTH, FOOD_BB_HEIGHT });
-
-	// Create an (empty) Bug component to be able to refer to all bug
-	//registry.eatables.emplace(entity);
-	registry.fireballs.emplace(entity);
-	registry.deadlys.emplace(entity);
-	registry.renderRequests.insert(
-		entity,
-		{ TEXTURE_ASSET_ID::GOLD1,
-		 EFFECT_ASSET_ID::TEXTURED,
-		 GEOMETRY_BUFFER_ID::SPRITE });
-
-	return entity;
+	static const auto fireball = spritePrefab<Fireball, Deadly>(renderer, TEXTURE_ASSET_ID::GOLD1, vec2({-FOOD_BB_WIDTH, FOOD_BB_HEIGHT}));
+	return spawn(fireball, position);
 }
 
 Entity createTitle(RenderSystem* renderer, vec2 position)
 {
-	// Reserve en entity
-	auto entity = Entity();
-
-	// Store a reference to the potentially re-used mesh object
-	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
-	registry.meshPtrs.emplace(entity, &mesh);
-
-	// Initialize the position, scale, and physics components
-	auto& motion = registry.motions.emplace(entity);
-	motion.angle = 0.f;
-	motion.velocity = { 0, 0 };
-	motion.position = position;
-
-	// Setting initial values, scale is negative to make it face the opposite way
-	motion.scale = vec2({ window_width_px*0.9, window_height_px/2*0.75 });
-
-	// Create an (empty) Bug component to be able to refer to all bug
-	//registry.eatables.emplace(entity);
-	registry.menus.emplace(entity);
-	registry.renderRequests.insert(
-		entity,
-		{ TEXTURE_ASSET_ID::TITLE,
-		 EFFECT_ASSET_ID::TEXTURED,
-		 GEOMETRY_BUFFER_ID::SPRITE });
-
-	return entity;
+	static const auto title = spritePrefab<MenuElement>(renderer, TEXTURE_ASSET_ID::TITLE, vec2({window_width_px * 0.9, window_height_px / 2 * 0.75}));
+	return spawn(title, position);
 }
 
 
 Entity createSpikeball(RenderSystem* renderer, vec2 position)
 {
-	// Reserve en entity
-	auto entity = Entity();
-
-	// Store a reference to the potentially re-used mesh object
-	Mesh& mesh = renderer->getMesh(GEOMETRY_BUFFER_ID::SPRITE);
-	registry.meshPtrs.emplace(entity, &mesh);
-
-	// Initialize the position, scale, and physics components
-	auto& motion = registry.motions.emplace(entity);
-	motion.angle = 0.f;
-	motion.velocity = { 0, 0 };
-	motion.position = position;
-
-	// Setting initial values, scale is negative to make it face the opposite way
-	motion.scale = vec2({ 48, 48 });
-
-	// Create an (empty) Bug component to be able to refer to all bug
-	//registry.eatables.emplace(entity);
-	//registry.fireballs.emplace(entity);
-	registry.spikeballs.emplace(entity);
-	registry.deadlys.emplace(entity);
-	registry.renderRequests.insert(
-		entity,
-		{ TEXTURE_ASSET_ID::SPIKEBALL,
-		 EFFECT_ASSET_ID::TEXTURED,
-		 GEOMETRY_BUFFER_ID::SPRITE });
-
-	return entity;
+	static const auto spikeball = spritePrefab<Spikeball, Deadly>(renderer, TEXTURE_ASSET_ID::SPIKEBALL, vec2({48, 48}));
+	return spawn(spikeball, position);
 }
\ No newline at end of file
@@ -31,6 +31,8 @@ const float ZOMBIE_BB_HEIGHT = 0.6f * 184.f;
 // platform
 const float PLATFORM_WIDTH = 24.2f;
 const float PLATFORM_HEIGHT = 24.2f;
+// the distance of the platform tiles of a map
+const float PLATFORM_TILE_SIZE = 10.f;
 
 // the zombie
 Entity createZombie(RenderSystem *renderer, vec2 position, int state = 0, double range = 200);
@@ -58,8 +60,7 @@ Entity createEagle(RenderSystem *renderer, vec2 position);
 // Josh
 Entity createJosh(RenderSystem *renderer, vec2 position);
 // Platform
-Entity createPlatform(RenderSystem* renderer, vec2 pos);
-Entity createPlatformVert(RenderSystem* renderer, vec2 pos);
+void createPlatforms(RenderSystem* renderer, const std::vector<std::pair<vec2, TEXTURE_ASSET_ID>>& tiles);
 //help help_sign
 Entity createHelpSign(RenderSystem* renderer, vec2 position);
 //help help_info
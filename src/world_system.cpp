@@ -3,10 +3,11 @@
 #include "world_init.hpp"
 #include "menu.hpp"
 #include "world_helper.hpp"
+#include "alloc_tracker.hpp"
+#include "tile_grid.hpp"
 
 // stlib
 #include <cassert>
-#include <sstream>
 #include <iostream>
 #include "physics_system.hpp"
 
@@ -284,6 +285,9 @@ void WorldSystem::init(RenderSystem *renderer_arg, DialogSystem *dialog_arg)
 	Mix_VolumeChunk(bonus_music, 30);
 	Mix_VolumeMusic(20);
 
+	// Entities created so far, e.g. the screen state, last as long as the game
+	Entity::enter_scope(level_scope);
+
 	// Set all states to default
 	restart_game();
 }
@@ -361,6 +365,7 @@ void handleMovementKeys(Entity entity)
 // Update our game world
 bool WorldSystem::step(float elapsed_ms_since_last_update)
 {
+	AllocScope alloc_scope(ALLOC_SECTION::WORLD);
 	//for josh movement animation
 	auto end = std::chrono::system_clock::now();
 
@@ -433,19 +438,6 @@ bool WorldSystem::step(float elapsed_ms_since_last_update)
 	}
 
 
-	// for fps counter
-	fpsTimer += elapsed_ms_since_last_update;
-	fpsCount++;
-	if (fpsTimer >= 1000.0f)
-	{
-		fpsTimer = 0.0f;
-		fps = fpsCount;
-		fpsCount = 0;
-		std::stringstream windowCaption;
-		windowCaption << "Escape from Celestria - FPS Counter: " << fps;
-		glfwSetWindowTitle(window, windowCaption.str().c_str());
-	}
-  
 	if (paused || showStartScreen)
 	{
 		for (int i = 0; i < buttons.size(); i++)
@@ -514,11 +506,8 @@ bool WorldSystem::step(float elapsed_ms_since_last_update)
 	}
 
 	// change josh's color gradually
-	auto &color_change_registry = registry.colorChanges;
-	for (int i = (int)color_change_registry.components.size() - 1; i >= 0; --i)
-	{
-		Entity entity = color_change_registry.entities[i];
-		ColorChange &color_change = color_change_registry.components[i];
+	// The entities are interpolated in parallel, missing colors are added and finished changes removed at the next flush
+	registry.parallel_each<ColorChange>([&](Entity entity, ColorChange &color_change) {
 		color_change.color_time_elapsed += elapsed_ms_since_last_update / 1000.0f;
 		float t = color_change.color_time_elapsed / color_change.color_duration;
 		if (t < 1.0f)
@@ -526,40 +515,36 @@ bool WorldSystem::step(float elapsed_ms_since_last_update)
 			vec3 color_new = lerp(color_change.color_start, color_change.color_end, t);
 			if (registry.colors.has(entity))
 			{
-				registry.colors.remove(entity);
-				registry.colors.emplace(entity, color_new);
+				registry.colors.get(entity) = color_new;
 			}
 			else
 			{
-				registry.colors.emplace(entity, color_new);
+				registry.commands().insert_if_missing(entity, color_new);
 			}
 		}
 		else
 		{
 			if (!registry.colors.has(entity))
 			{
-				registry.colors.emplace(entity, color_change.color_end);
+				registry.commands().insert_if_missing(entity, color_change.color_end);
 			}
 			else
 			{
-				registry.colorChanges.remove(entity);
+				registry.commands().remove<ColorChange>(entity);
 			}
 		}
-	}
+	});
 
 	// Linear interpolation: movement
-	for (Entity entity : registry.linearMovements.entities)
-	{
-		auto &movement = registry.linearMovements.get(entity);
+	registry.parallel_each<LinearMovement, Motion>([&](Entity entity, LinearMovement &movement, Motion &motion) {
 		movement.time_elapsed += elapsed_ms_since_last_update / 1000.0f;
 		float t = movement.time_elapsed / movement.duration;
 		if (t < 1.0f)
 		{
 			vec3 displacement3D = lerp(vec3(movement.pos_start, 0.0f), vec3(movement.pos_end, 0.0f), t);
-			Motion &motion = registry.motions.get(entity);
 			motion.position = {displacement3D.x, displacement3D.y};
 		}
-	}
+	});
 
 	// Processing the chicken state
 	assert(registry.screenStates.components.size() <= 1);
@@ -649,8 +634,7 @@ bool WorldSystem::step(float elapsed_ms_since_last_update)
 			}
 			if (zombie.death_counter < 1.0)
 			{
-				registry.renderRequests.remove(entity);
-				registry.remove_all_components_of(entity);
+				registry.commands().destroy(entity);
 			}
 		}
 	}
@@ -690,7 +674,7 @@ bool WorldSystem::step(float elapsed_ms_since_last_update)
 	// recreate Health base on current hp_count
 	for (Entity entity : registry.hearts.entities)
 	{
-		registry.remove_all_components_of(entity);
+		registry.commands().destroy(entity);
 	}
 
 	// The first and last levels doesn't need heart
@@ -746,7 +730,7 @@ bool WorldSystem::step(float elapsed_ms_since_last_update)
 
 	for (Entity entity : registry.smallKeys.entities)
 	{
-		registry.remove_all_components_of(entity);
+		registry.commands().destroy(entity);
 	}
 	if (have_key)
 	{
@@ -806,6 +790,25 @@ bool WorldSystem::createEntityBaseOnMap(std::vector<std::vector<char>> map, bool
 		createBackgroundImage(backgrounds[currentLevel]);
 	}
 
+	// Create the platforms in one batch, in front of the background and behind everything else
+	std::vector<std::pair<vec2, TEXTURE_ASSET_ID>> platformTiles;
+	for (int i = 0; i < map.size(); i++)
+	{
+		for (int j = 0; j < map[i].size(); j++)
+		{
+			if (map[i][j] == 'P')
+			{
+				platformTiles.push_back({ vec2(j * PLATFORM_TILE_SIZE, i * PLATFORM_TILE_SIZE), TEXTURE_ASSET_ID::PLATFORM });
+			}
+			else if (map[i][j] == 'V')
+			{
+				platformTiles.push_back({ vec2(j * PLATFORM_TILE_SIZE, i * PLATFORM_TILE_SIZE), TEXTURE_ASSET_ID::GROUNDVERT });
+			}
+		}
+	}
+	createPlatforms(renderer, platformTiles);
+	level_tiles.assign(map, "PV", PLATFORM_TILE_SIZE, { PLATFORM_WIDTH, PLATFORM_HEIGHT });
+
 	// Create all other entities except for background
 	for (int i = 0; i < map.size(); i++)
 	{
@@ -832,7 +835,6 @@ bool WorldSystem::createEntityBaseOnMap(std::vector<std::vector<char>> map, bool
 					graph.addEdge(latest, newV, ACTION::WALK);
 				}
 				latest = newV;
-				createPlatform(renderer, { x, y });
 			}
 			else if (tok == 'V')
 			{
@@ -845,7 +847,6 @@ bool WorldSystem::createEntityBaseOnMap(std::vector<std::vector<char>> map, bool
 					graph.addEdge(latest, newV, ACTION::WALK);
 				}
 				latest = newV;
-				createPlatformVert(renderer, { x, y });
 			}
 			else if (tok == 'Z' && !plat_only)
 			{
@@ -960,13 +961,13 @@ void WorldSystem::restart_game()
 		tutorial_index = 0;
 	}
 
-	// Remove all entities that we created
-	// All that have a motion, we could also iterate over all bug, eagles, ... but that would be more cumbersome
-	while (registry.motions.entities.size() > 0)
-		registry.remove_all_components_of(registry.motions.entities.back());
+	// Remove all entities that we created for the level, one sweep per container
+	registry.destroy_scope(level_scope);
+	level_tiles.clear();
+	renderer->snapPreviousMotions();
 
-	while (registry.speechPoint.entities.size() > 0)
-		registry.remove_all_components_of(registry.speechPoint.entities.back());
+	// Loading the level allocates, the frames after it are not steady yet
+	AllocTracker::warm_up();
 
 	// Debugging for memory/component leaks
 	registry.list_all_components();
@@ -1024,10 +1025,7 @@ void WorldSystem::restart_game()
 		
 
 		showStartScreen = false;
-		for (Entity entity : registry.menus.entities)
-		{
-			registry.remove_all_components_of(entity);
-		}
+		clearMenu();
 		auto map = loadMap(map_path() + "level" + std::to_string(currentLevel) + ".txt");
 		createEntityBaseOnMap(map);
 
@@ -1041,11 +1039,30 @@ void WorldSystem::restart_game()
 
 }
 
+// The steps run at a fixed rate, so the frames are counted where they are drawn
+void WorldSystem::countFrame(float elapsed_ms)
+{
+	fpsTimer += elapsed_ms;
+	fpsCount++;
+	if (fpsTimer >= 1000.0f)
+	{
+		fpsTimer = 0.0f;
+		fps = fpsCount;
+		fpsCount = 0;
+		// Formatted on the stack, the frames after the warm-up must not allocate
+		char windowCaption[64];
+		snprintf(windowCaption, sizeof(windowCaption), "Escape from Celestria - FPS Counter: %d", (int)fps);
+		glfwSetWindowTitle(window, windowCaption);
+	}
+}
+
 // Compute collisions between entities
 void WorldSystem::handle_collisions()
 {
 	// Loop over all collisions detected by the physics system
+	// Entities are destroyed through the command buffer, removing them right away would reorder the collisions
 	auto &collisionsRegistry = registry.collisions;
+	auto &commands = registry.commands();
 	for (uint i = 0; i < collisionsRegistry.components.size(); i++)
 	{
 		// The entity and its collider
@@ -1062,7 +1079,7 @@ void WorldSystem::handle_collisions()
 				std::string text = tb.text;
 				createText({ 300, 300 }, 1, { 1, 1, 1 }, text);
 				// remove used text block
-				registry.remove_all_components_of(entity_other);
+				commands.destroy(entity_other);
 			}
 			// Player& player = registry.players.get(entity);
 			// Checking Player - Deadly collisions
@@ -1078,13 +1095,9 @@ void WorldSystem::handle_collisions()
 				{
 
 					// Game over and update the hearts
-					uint i = 0;
-					while (i < registry.hearts.components.size())
+					for (Entity heart : registry.hearts.entities)
 					{
-						Entity entity = registry.hearts.entities[i];
-						registry.meshPtrs.remove(entity);
-						registry.hearts.remove(entity);
-						registry.renderRequests.remove(entity);
+						commands.destroy(heart);
 					}
 					for (int i = 0; i < hp_count - 1; i++)
 					{
@@ -1119,13 +1132,9 @@ void WorldSystem::handle_collisions()
 					// std::cout << "hp count: " << hp_count << std::endl;
 
 					// update hearts
-					uint i = 0;
-					while (i < registry.hearts.components.size())
+					for (Entity heart : registry.hearts.entities)
 					{
-						Entity entity = registry.hearts.entities[i];
-						registry.meshPtrs.remove(entity);
-						registry.hearts.remove(entity);
-						registry.renderRequests.remove(entity);
+						commands.destroy(heart);
 					}
 					for (int i = 0; i < hp_count; i++)
 					{
@@ -1144,17 +1153,13 @@ void WorldSystem::handle_collisions()
 				{
 					// chew, add hp if hp is not full
 					Mix_PlayChannel(-1, eat_music, 0);
-					registry.remove_all_components_of(entity_other);
+					commands.destroy(entity_other);
 					++hp_count;
 					// std::cout << "hp count: " << hp_count << std::endl;
 
-					uint i = 0;
-					while (i < registry.hearts.components.size())
+					for (Entity heart : registry.hearts.entities)
 					{
-						Entity entity = registry.hearts.entities[i];
-						registry.meshPtrs.remove(entity);
-						registry.hearts.remove(entity);
-						registry.renderRequests.remove(entity);
+						commands.destroy(heart);
 					}
 					for (int i = 0; i < hp_count; i++)
 					{
@@ -1163,7 +1168,7 @@ void WorldSystem::handle_collisions()
 				}
 				else if (registry.bullets.has(entity_other)&&tutorial_can_get_bullet)
 				{
-					registry.remove_all_components_of(entity_other);
+					commands.destroy(entity_other);
 					bullets_count = bullets_count + 1;
 					// std::cout << "bullets count: " << bullets_count << std::endl;
 
@@ -1178,7 +1183,7 @@ void WorldSystem::handle_collisions()
 				}
 				else if (registry.keys.has(entity_other) && tutorial_can_grab_key)
 				{
-					registry.remove_all_components_of(entity_other);
+					commands.destroy(entity_other);
 					have_key = true;
 					// std::cout << "have key: " << have_key << std::endl;
 					showKeyOnScreen(renderer, have_key);
@@ -1186,7 +1191,7 @@ void WorldSystem::handle_collisions()
 				}
 				else if (registry.golds.has(entity_other))
 				{
-					registry.remove_all_components_of(entity_other);
+					commands.destroy(entity_other);
 					// registry.invincibleTimers.emplace(entity);
 					////vec4 invincible_color = { 1.0f, 1.0f, 0.6f, 0.6f };
 					// color = registry.colors.get(entity);
@@ -1266,8 +1271,7 @@ void WorldSystem::handle_collisions()
 				registry.renderRequests.get(entity) = {TEXTURE_ASSET_ID::ZOMBIE_DIE,
 													   EFFECT_ASSET_ID::TEXTURED,
 													   GEOMETRY_BUFFER_ID::SPRITE};
-				registry.remove_all_components_of(entity_other);
-				registry.renderRequests.remove(entity_other);
+				commands.destroy(entity_other);
 				registry.deadlys.remove(entity);
 				zombie.is_dead = true;
 			}
@@ -1289,6 +1293,7 @@ void WorldSystem::handle_collisions()
 	}
 	// Remove all collisions from this simulation step
 	registry.collisions.clear();
+	registry.flush_commands();
 }
 
 // Show the key on top left of the screen
@@ -1303,7 +1308,7 @@ void WorldSystem::showKeyOnScreen(RenderSystem *renderer, bool have_key)
 	{
 		// remove key from screen
 		uint i = 0;
-		while (i < registry.keys.components.size())
+		while (i < registry.keys.size())
 		{
 			Entity entity = registry.keys.entities[i];
 			registry.meshPtrs.remove(entity);
@@ -1399,10 +1404,7 @@ void WorldSystem::on_key(int key, int, int action, int mod)
 			}
 			else
 			{
-				for (Entity entity : registry.menus.entities)
-				{
-					registry.remove_all_components_of(entity);
-				}
+				clearMenu();
 				buttons.clear();
 			}
 		}
@@ -1531,7 +1533,7 @@ void WorldSystem::on_key(int key, int, int action, int mod)
 			}
 			
 			uint i = 0;
-			while (i < registry.hearts.components.size())
+			while (i < registry.hearts.size())
 			{
 				Entity entity = registry.hearts.entities[i];
 				registry.meshPtrs.remove(entity);
@@ -1737,7 +1739,7 @@ void WorldSystem::hideJosh(RenderSystem *renderer)
 void WorldSystem::removeSmallBullets(RenderSystem *renderer)
 {
 	uint i = 0;
-	while (i < registry.smallBullets.components.size())
+	while (i < registry.smallBullets.size())
 	{
 		Entity entity = registry.smallBullets.entities[i];
 		registry.remove_all_components_of(entity);
@@ -47,6 +47,9 @@ public:
 	// Steps the game ahead by ms milliseconds
 	bool step(float elapsed_ms);
 
+	// Counts a drawn frame for the FPS in the window title, elapsed_ms is the real time since the last one
+	void countFrame(float elapsed_ms);
+
 	// Check for collisions
 	void handle_collisions();
 
@@ -88,6 +91,8 @@ private:
 	vec2 cubicBezier(vec2 &p0, vec2 &p1, vec2 &p2, vec2 &p3, float t);
 
 	// restart level
+	// Everything created while a level is running belongs to this entity scope and goes with the level
+	static constexpr unsigned char level_scope = 1;
 	void restart_game();
 
 